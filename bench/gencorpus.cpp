@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+/// Corpus generator
+/// ----------------------------------------------------------------------------
+/// Writes a C source of about `bytes` bytes to stdout for `lexbench`, the
+/// same for the same arguments.
+///
+///     comments    : license headers, doc comments and trailing line
+///                   comments around short declarations
+///     identifiers : identifiers, a third of them keywords
+///
+/// The default size stays below the 4 MB from which `lex()` lexes in
+/// parallel, so the numbers are those of one thread.
+static const char *const kLicense =
+    "/*\n"
+    " * Copyright (c) The project authors. All rights reserved.\n"
+    " *\n"
+    " * Permission is hereby granted, free of charge, to any person obtaining a copy\n"
+    " * of this software and associated documentation files, to deal in the\n"
+    " * software without restriction, including without limitation the rights to\n"
+    " * use, copy, modify, merge, publish, distribute, sublicense, and/or sell\n"
+    " * copies of the software, subject to the following conditions.\n"
+    " */\n";
+
+static const char *const kDoc =
+    "/**\n"
+    " * Returns the number of elements in the list, walking it from the head.\n"
+    " * @param list  the list, may be empty but not null\n"
+    " * @return      the count\n"
+    " */\n";
+
+static const char *const kKeywords[] = {"int", "char", "return", "if", "else", "while", "for", "static", "const", "unsigned", "struct", "void"};
+
+static auto comments(std::string &out, size_t bytes, std::mt19937 &rng) -> void {
+    for (size_t i = 0; out.size() < bytes; ++i) {
+        if (i % 64 == 0) out += kLicense;
+        if (rng() % 4 == 0) out += kDoc;
+        out += "int count_" + std::to_string(i) + "(int *list);";
+        out += rng() % 2 ? "  // walks the whole list, O(n)\n" : "\n";
+    }
+}
+
+static auto identifiers(std::string &out, size_t bytes, std::mt19937 &rng) -> void {
+    static const char kChars[] = "abcdefghijklmnopqrstuvwxyz_0123456789";
+    for (size_t i = 0; out.size() < bytes; ++i) {
+        if (rng() % 3 == 0) {
+            out += kKeywords[rng() % std::size(kKeywords)];
+        } else {
+            out += kChars[rng() % 26];
+            for (auto length = rng() % 12; length > 0; --length) out += kChars[rng() % (sizeof(kChars) - 1)];
+        }
+        out += i % 12 == 11 ? '\n' : ' ';
+    }
+}
+
+auto main(int argc, const char** argv) -> int {
+    const auto mode  = argc > 1 ? argv[1] : "";
+    const auto bytes = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4000000ull;
+
+    std::mt19937 rng(42);
+    std::string out;
+    out.reserve(bytes + 1024);
+    if (std::strcmp(mode, "comments") == 0) {
+        comments(out, bytes, rng);
+    } else if (std::strcmp(mode, "identifiers") == 0) {
+        identifiers(out, bytes, rng);
+    } else {
+        std::printf("\nUsage: gencorpus <comments | identifiers> [bytes]\n\n");
+        return 1;
+    }
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    return 0;
+}
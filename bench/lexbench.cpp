@@ -0,0 +1,41 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "mcc.hpp"
+
+/// Lexer benchmark
+/// ----------------------------------------------------------------------------
+/// Lexes each file `runs` times after loading it once, so reading the file is
+/// not measured, and prints the fastest run. Files of 4 MB or more go through
+/// the parallel lexer on a multi-core host, as in `mcc`. Corpora for it come
+/// from `gencorpus`.
+auto main(int argc, const char** argv) -> int {
+    int runs  = 20;
+    int first = 1;
+    if (argc > 2 && std::strcmp(argv[1], "-n") == 0) runs = std::max(1, std::atoi(argv[2])), first = 3;
+    if (first >= argc) {
+        std::printf("\nUsage: lexbench [-n runs] <file>...\n\n");
+        return 1;
+    }
+
+    for (int i = first; i < argc; ++i) {
+        const auto file = mcc::SourceManager::instance().load(argv[i]);
+        const auto size = mcc::SourceManager::instance().buffer(file).size();
+
+        size_t tokens = 0;
+        auto best     = std::chrono::nanoseconds::max();
+        for (int run = 0; run < runs; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            auto ts          = mcc::lex(mcc::SrcStream(file));
+            for (tokens = 0; ts; ++tokens) ts.next();
+            best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+        }
+
+        const auto ms = best.count() / 1e6;
+        std::printf("%s: %zu bytes, %zu tokens, best of %d: %.2f ms, %.1f MB/s\n", argv[i], size, tokens, runs, ms, size / 1e3 / ms);
+    }
+    return 0;
+}
@@ -31,7 +31,7 @@ auto AstFormatter::visitAstProgram(AstProgram &ast) -> void {
     }
 }
 auto AstFormatter::visitAstDeclVar(AstDeclVar &ast) -> void {
-    os() << ast.type().format(ast.name());
+    os() << ast.type().format(std::string(ast.name().string()));
 
     if (ast.initial()) {
         m_os << " = ";
@@ -41,7 +41,7 @@ auto AstFormatter::visitAstDeclVar(AstDeclVar &ast) -> void {
     m_os << ";\n";
 }
 auto AstFormatter::visitAstDeclFunc(AstDeclFunc &ast) -> void {
-    os() << ast.type().format(ast.name());
+    os() << ast.type().format(std::string(ast.name().string()));
     if (ast.body()) {
         m_os << '\n';
         indent([&] { ast.body()->accept(*this); });
@@ -182,13 +182,13 @@ auto AstFormatter::visitAstExprFuncCall(AstExprFuncCall &ast) -> void {
     m_os << ')';
 }
 auto AstFormatter::visitAstExprString(AstExprString &ast) -> void {
-    m_os << '\"' << ast.value() << '\"';
+    m_os << '\"' << escape_literal(ast.value().string(), '\"') << '\"';
 }
 auto AstFormatter::visitAstExprConstant(AstExprConstant &ast) -> void {
-    m_os << ast.value();
+    m_os << ast.spelling();
 }
 auto AstFormatter::visitAstExprCharacter(AstExprCharacter &ast) -> void {
-    m_os << '\'' << ast.value() << '\'';
+    m_os << '\'' << escape_literal(ast.value().string(), '\'') << '\'';
 }
 auto AstFormatter::visitAstExprIdentifier(AstExprIdentifier &ast) -> void {
     m_os << ast.name();
@@ -39,7 +39,7 @@ auto AstHighlighter::visitAstProgram(AstProgram &ast) -> void {
     }
 }
 auto AstHighlighter::visitAstDeclVar(AstDeclVar &ast) -> void {
-    os() << MCC_COLOR_GREEN + ast.type().format(MCC_COLOR_CYAN + ast.name() + MCC_COLOR_GREEN) + MCC_COLOR_RESET;
+    os() << MCC_COLOR_GREEN + ast.type().format(MCC_COLOR_CYAN + std::string(ast.name().string()) + MCC_COLOR_GREEN) + MCC_COLOR_RESET;
 
     if (ast.initial()) {
         m_os << " = ";
@@ -49,7 +49,7 @@ auto AstHighlighter::visitAstDeclVar(AstDeclVar &ast) -> void {
     m_os << ";\n";
 }
 auto AstHighlighter::visitAstDeclFunc(AstDeclFunc &ast) -> void {
-    os() << MCC_COLOR_GREEN + ast.type().format(MCC_COLOR_CYAN + ast.name() + MCC_COLOR_GREEN) + MCC_COLOR_RESET;
+    os() << MCC_COLOR_GREEN + ast.type().format(MCC_COLOR_CYAN + std::string(ast.name().string()) + MCC_COLOR_GREEN) + MCC_COLOR_RESET;
     if (ast.body()) {
         m_os << '\n';
         indent([&] { ast.body()->accept(*this); });
@@ -190,13 +190,13 @@ auto AstHighlighter::visitAstExprFuncCall(AstExprFuncCall &ast) -> void {
     m_os << ')';
 }
 auto AstHighlighter::visitAstExprString(AstExprString &ast) -> void {
-    m_os << MCC_COLOR_YELLOW "\"" << ast.value() << "\"" MCC_COLOR_RESET;
+    m_os << MCC_COLOR_YELLOW "\"" << escape_literal(ast.value().string(), '\"') << "\"" MCC_COLOR_RESET;
 }
 auto AstHighlighter::visitAstExprConstant(AstExprConstant &ast) -> void {
-    m_os << MCC_COLOR_YELLOW << ast.value() << MCC_COLOR_RESET;
+    m_os << MCC_COLOR_YELLOW << ast.spelling() << MCC_COLOR_RESET;
 }
 auto AstHighlighter::visitAstExprCharacter(AstExprCharacter &ast) -> void {
-    m_os << MCC_COLOR_YELLOW "\'" << ast.value() << "\'" MCC_COLOR_RESET;
+    m_os << MCC_COLOR_YELLOW "\'" << escape_literal(ast.value().string(), '\'') << "\'" MCC_COLOR_RESET;
 }
 auto AstHighlighter::visitAstExprIdentifier(AstExprIdentifier &ast) -> void {
     m_os << MCC_COLOR_CYAN << ast.name() << MCC_COLOR_RESET;
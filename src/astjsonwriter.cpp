@@ -2,8 +2,40 @@
 
 #include <iostream>
 
+#include "simd.hpp"
+
 namespace mcc {
 
+/// writes the decoded bytes of a literal as a JSON string
+static auto write_literal(std::ostream &os, Literal literal) -> void {
+    static constexpr char kHex[] = "0123456789abcdef";
+
+    os << '"';
+    const auto bytes = literal.string();
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        const auto ch   = bytes[i];
+        const auto byte = static_cast<unsigned char>(ch);
+        if (ch == '"' || ch == '\\') {
+            os << '\\' << ch;
+        } else if (ch == '\n') {
+            os << "\\n";
+        } else if (ch == '\t') {
+            os << "\\t";
+        } else if (ch == '\r') {
+            os << "\\r";
+        } else if (const auto length = byte >= 0x80 ? simd::utf8_length(&bytes[i], bytes.data() + bytes.size()) : 0) {
+            os.write(&bytes[i], length);
+            i += length - 1;
+        } else if (byte < 0x20 || byte >= 0x7f) {
+            // one code point per byte that is not UTF-8
+            os << "\\u00" << kHex[byte >> 4] << kHex[byte & 15];
+        } else {
+            os << ch;
+        }
+    }
+    os << '"';
+}
+
 inline auto AstJsonWriter::or_accept(IAst *ast) -> void {
     if (ast) {
         ast->accept(*this);
@@ -169,15 +201,17 @@ auto AstJsonWriter::visitAstExprFuncCall(AstExprFuncCall &ast) -> void {
 }
 auto AstJsonWriter::visitAstExprString(AstExprString &ast) -> void {
     m_os << "{\"kind\":\"string literal\",\"value\":";
-    m_os << '"' << ast.value() << "\"}";
+    write_literal(m_os, ast.value());
+    m_os << '}';
 }
 auto AstJsonWriter::visitAstExprConstant(AstExprConstant &ast) -> void {
     m_os << "{\"kind\":\"constant\",\"value\":";
-    m_os << '"' << ast.value() << "\"}";
+    m_os << '"' << ast.spelling() << "\"}";
 }
 auto AstJsonWriter::visitAstExprCharacter(AstExprCharacter &ast) -> void {
     m_os << "{\"kind\":\"character\",\"value\":";
-    m_os << '"' << ast.value() << "\"}";
+    write_literal(m_os, ast.value());
+    m_os << '}';
 }
 auto AstJsonWriter::visitAstExprIdentifier(AstExprIdentifier &ast) -> void {
     m_os << "{\"kind\":\"identifier\",\"name\":";
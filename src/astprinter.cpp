@@ -157,13 +157,13 @@ auto AstPrinter::visitAstExprFuncCall(AstExprFuncCall &ast) -> void {
     });
 }
 auto AstPrinter::visitAstExprString(AstExprString &ast) -> void {
-    os() << "string: \"" << ast.value() << "\"\n";
+    os() << "string: \"" << escape_literal(ast.value().string(), '\"') << "\"\n";
 }
 auto AstPrinter::visitAstExprConstant(AstExprConstant &ast) -> void {
-    os() << "constant: " << ast.value() << "\n";
+    os() << "constant: " << ast.spelling() << "\n";
 }
 auto AstPrinter::visitAstExprCharacter(AstExprCharacter &ast) -> void {
-    os() << "character: \'" << ast.value() << "\'\n";
+    os() << "character: \'" << escape_literal(ast.value().string(), '\'') << "\'\n";
 }
 auto AstPrinter::visitAstExprIdentifier(AstExprIdentifier &ast) -> void {
     os() << "identifier: " << ast.name() << "\n";
@@ -5,6 +5,7 @@
 #include "astfwd.hpp"
 #include "operator.hpp"
 #include "scope.hpp"
+#include "token.hpp"
 #include "type.hpp"
 
 namespace mcc {
@@ -57,15 +58,14 @@ private:
 /// ----------------------------------------------------------------------------
 class IAstDecl : public IAst {
 public:
-    static constexpr std::string_view kAnonymous = "";
+    static constexpr Symbol kAnonymous = Symbol();
 
     ~IAstDecl() override = default;
 
     auto accept(IAstVisitor &) -> void override = 0;
 
-    IAstDecl(QualType type, std::string_view name = kAnonymous)
+    IAstDecl(QualType type, Symbol name = kAnonymous)
         : m_type(type), m_name(name) {}
-    IAstDecl(QualType type, std::string name) : m_type(type), m_name(name) {}
 
     inline auto &type() { return m_type; }
     inline auto &name() { return m_name; }
@@ -74,7 +74,7 @@ public:
 
 private:
     QualType m_type;
-    std::string m_name;
+    Symbol m_name;
 };
 
 /// AstDeclVar
@@ -83,7 +83,7 @@ class AstDeclVar final : public IAstDecl {
 public:
     ~AstDeclVar() override = default;
     auto accept(IAstVisitor &) -> void override;
-    AstDeclVar(StorageClass storage, QualType type, AstExprPointer &&init, std::string_view name = kAnonymous)
+    AstDeclVar(StorageClass storage, QualType type, AstExprPointer &&init, Symbol name = kAnonymous)
         : IAstDecl(type, name), m_storage(storage), m_initial(std::move(init)) {}
 
     inline auto &initial() { return m_initial; }
@@ -103,7 +103,7 @@ public:
     auto accept(IAstVisitor &) -> void override;
     AstDeclFunc(StorageClass storage, QualType type,
                 std::unique_ptr<AstStmtCompound> &&body,
-                std::string_view name = kAnonymous)
+                Symbol name = kAnonymous)
         : IAstDecl(type, name),
           m_storage(storage),
           m_body(std::move(body)),
@@ -139,13 +139,13 @@ class AstStmtJumpGoto : public IAstStmt {
 public:
     ~AstStmtJumpGoto() override = default;
     auto accept(IAstVisitor &) -> void override;
-    AstStmtJumpGoto(std::string_view lable) : m_lable(lable) {}
+    AstStmtJumpGoto(Symbol lable) : m_lable(lable) {}
 
     inline auto &lable() { return m_lable; }
     inline auto &lable() const { return m_lable; }
 
 private:
-    std::string m_lable;
+    Symbol m_lable;
 };
 class AstStmtJumpBreak : public IAstStmt {
 public:
@@ -174,13 +174,13 @@ public:
     ~AstStmtLable() override = default;
     auto accept(IAstVisitor &) -> void override;
 
-    AstStmtLable(std::string_view lable) : m_lable(lable) {}
+    AstStmtLable(Symbol lable) : m_lable(lable) {}
 
     inline auto &lable() { return m_lable; }
     inline auto &lable() const { return m_lable; }
 
 private:
-    std::string m_lable;
+    Symbol m_lable;
 };
 class AstStmtLableCase : public IAstStmt {
 public:
@@ -414,49 +414,53 @@ class AstExprConstant : public IAstExpr {
 public:
     ~AstExprConstant() override = default;
     auto accept(IAstVisitor &) -> void override;
-    AstExprConstant(std::string_view value) : m_value(value) {}
+    AstExprConstant(Constant value, SrcLoc loc, uint32_t length) : m_value(value), m_loc(loc), m_length(length) {}
 
     inline auto &value() { return m_value; }
     inline auto &value() const { return m_value; }
+    /// the constant as written, read back from the source
+    inline auto spelling() const { return SourceManager::instance().text(m_loc, m_length); }
 
 private:
-    std::string m_value;
+    Constant m_value;
+    SrcLoc m_loc;
+    uint32_t m_length;
 };
 class AstExprCharacter : public IAstExpr {
 public:
     ~AstExprCharacter() override = default;
     auto accept(IAstVisitor &) -> void override;
-    AstExprCharacter(std::string_view value) : m_value(value) {}
+    AstExprCharacter(Literal value) : m_value(value) {}
 
     inline auto &value() { return m_value; }
     inline auto &value() const { return m_value; }
 
 private:
-    std::string m_value;
+    Literal m_value;
 };
 class AstExprString : public IAstExpr {
 public:
     ~AstExprString() override = default;
     auto accept(IAstVisitor &) -> void override;
-    AstExprString(std::string_view value) : m_value(value) {}
+    AstExprString(Literal value) : m_value(value) {}
 
     inline auto &value() { return m_value; }
     inline auto &value() const { return m_value; }
 
 private:
-    std::string m_value;
+    Literal m_value;
 };
 class AstExprIdentifier : public IAstExpr {
 public:
     ~AstExprIdentifier() override = default;
     auto accept(IAstVisitor &) -> void override;
-    AstExprIdentifier(std::string_view name) : m_name(name) {}
+    AstExprIdentifier(Symbol name) : m_name(name) {}
 
     inline auto &name() { return m_name; }
     inline auto &name() const { return m_name; }
 
 private:
-    std::string m_name;
+    Symbol m_name;
 };
 
 }  // namespace mcc
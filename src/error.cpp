@@ -20,14 +20,13 @@ namespace mcc {
 }
 
 [[noreturn]] extern auto panic(const std::string& msg, SrcLoc loc) -> void {
-    auto delim = std::strchr(loc.lineptr, '\n');
-    std::string_view line(loc.lineptr, delim ? delim - loc.lineptr : std::strlen(loc.lineptr));
+    auto where = SourceManager::instance().resolve(loc);
 
     std::cerr
         << MCC_COLOR_RED "error occurred at "
-        << loc.srcfile << ':' << loc.linenum << ':'
-        << loc.current - loc.lineptr + 1 << ':'
-        << MCC_COLOR_RESET "\n>>> " << line
+        << where.srcfile << ':' << where.linenum << ':'
+        << where.column << ':'
+        << MCC_COLOR_RESET "\n>>> " << where.line
         << MCC_COLOR_GREEN "\n>>> " << msg
         << MCC_COLOR_RESET "\n";
 
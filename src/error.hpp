@@ -1,6 +1,6 @@
 #pragma once
 
-#include "srcstream.hpp"
+#include "srcmanager.hpp"
 
 namespace mcc {
 
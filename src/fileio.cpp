@@ -0,0 +1,272 @@
+#include "fileio.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "error.hpp"
+
+#if __has_include(<unistd.h>)
+#define MCC_HAS_POSIX 1
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#else
+#define MCC_HAS_POSIX 0
+#include <fstream>
+#endif
+
+#if MCC_HAS_POSIX && __has_include(<linux/io_uring.h>)
+#define MCC_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#else
+#define MCC_HAS_IO_URING 0
+#endif
+
+#if MCC_HAS_IO_URING && !defined(__NR_io_uring_setup)
+#undef MCC_HAS_IO_URING
+#define MCC_HAS_IO_URING 0
+#endif
+
+namespace mcc {
+
+namespace detail {
+
+constexpr size_t kMaxThreads  = 4;
+constexpr unsigned kRingDepth = 64;
+
+/// reads one file with plain blocking calls.
+static auto read_file(FileRead &file) -> void {
+    file.ok = false;
+    file.data.resize(file.size);
+
+#if MCC_HAS_POSIX
+    int fd = ::open(file.path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    size_t done = 0;
+    while (done < file.size) {
+        auto count = ::pread(fd, &file.data[done], file.size - done, done);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break;
+        done += count;
+    }
+
+    ::close(fd);
+    file.ok = done == file.size;
+#else
+    std::ifstream stream(file.path, std::ios::binary);
+    file.ok = stream.read(file.data.data(), file.size) && stream.gcount() == std::streamsize(file.size);
+#endif
+}
+
+/// hands the files out to at most `kMaxThreads` threads, the calling thread
+/// being one of them.
+static auto read_threaded(std::vector<FileRead> &batch) -> void {
+    const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+    const auto count    = std::min({batch.size(), size_t(hardware), kMaxThreads});
+
+    std::atomic<size_t> next{0};
+    auto worker = [&batch, &next] {
+        for (size_t i; (i = next++) < batch.size();) read_file(batch[i]);
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < count; ++i) threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads) thread.join();
+}
+
+#if MCC_HAS_IO_URING
+/// Ring
+/// ----------------------------------------------------------------------------
+/// A bare io_uring set up with the raw syscalls, so there is no dependency on
+/// liburing. `run()` submits a list of operations and waits for all of them.
+class Ring {
+public:
+    Ring(unsigned depth);
+    ~Ring();
+    Ring(Ring &&)      = delete;
+    Ring(const Ring &) = delete;
+    auto operator=(Ring &&) -> Ring & = delete;
+    auto operator=(const Ring &) -> Ring & = delete;
+
+    inline operator bool() const { return m_sqes != nullptr; }
+
+    /// `results[i]` is the result of `ops[i]`, a negated errno on failure
+    auto run(std::vector<io_uring_sqe> &ops, std::vector<int> &results) -> void;
+
+private:
+    auto enter(unsigned submit) -> unsigned;
+
+    int m_fd;
+    unsigned m_depth;
+    void *m_sq;
+    void *m_cq;
+    size_t m_sq_size;
+    size_t m_cq_size;
+    io_uring_sqe *m_sqes;
+    unsigned *m_sq_tail;
+    unsigned *m_sq_mask;
+    unsigned *m_sq_array;
+    unsigned *m_cq_head;
+    unsigned *m_cq_tail;
+    unsigned *m_cq_mask;
+    io_uring_cqe *m_cqes;
+};
+
+Ring::Ring(unsigned depth)
+    : m_fd(-1), m_depth(0), m_sq(MAP_FAILED), m_cq(MAP_FAILED), m_sq_size(0), m_cq_size(0), m_sqes(nullptr) {
+    io_uring_params params{};
+    m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+    if (m_fd < 0) return;
+
+    const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    m_sq_size         = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cq_size         = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (single) m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+
+    m_sq = ::mmap(nullptr, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+    m_cq = single ? m_sq : ::mmap(nullptr, m_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+
+    auto sqes = ::mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+    if (m_sq == MAP_FAILED || m_cq == MAP_FAILED || sqes == MAP_FAILED) {
+        // the rest is released by the destructor, `m_sqes` stays null
+        if (sqes != MAP_FAILED) ::munmap(sqes, params.sq_entries * sizeof(io_uring_sqe));
+        return;
+    }
+
+    auto sq    = static_cast<char *>(m_sq);
+    auto cq    = static_cast<char *>(m_cq);
+    m_depth    = params.sq_entries;
+    m_sqes     = static_cast<io_uring_sqe *>(sqes);
+    m_sq_tail  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    m_sq_mask  = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    m_sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    m_cq_head  = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    m_cq_tail  = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    m_cq_mask  = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    m_cqes     = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+Ring::~Ring() {
+    if (m_sqes) ::munmap(m_sqes, m_depth * sizeof(io_uring_sqe));
+    if (m_cq != MAP_FAILED && m_cq != m_sq) ::munmap(m_cq, m_cq_size);
+    if (m_sq != MAP_FAILED) ::munmap(m_sq, m_sq_size);
+    if (m_fd >= 0) ::close(m_fd);
+}
+
+/// submits up to `submit` entries and waits for at least one completion,
+/// returns how many entries the kernel took.
+auto Ring::enter(unsigned submit) -> unsigned {
+    for (;;) {
+        auto ret = ::syscall(__NR_io_uring_enter, m_fd, submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (ret >= 0) return static_cast<unsigned>(ret);
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY) panic("io_uring_enter failed");
+    }
+}
+
+auto Ring::run(std::vector<io_uring_sqe> &ops, std::vector<int> &results) -> void {
+    results.assign(ops.size(), -ECANCELED);
+
+    for (size_t first = 0; first < ops.size(); first += m_depth) {
+        const auto count = static_cast<unsigned>(std::min<size_t>(m_depth, ops.size() - first));
+
+        auto tail = *m_sq_tail;
+        for (unsigned i = 0; i < count; ++i, ++tail) {
+            const auto index        = tail & *m_sq_mask;
+            m_sqes[index]           = ops[first + i];
+            m_sqes[index].user_data = first + i;
+            m_sq_array[index]       = index;
+        }
+        __atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+
+        for (unsigned submitted = 0, completed = 0; completed < count;) {
+            submitted += enter(count - submitted);
+
+            auto head       = *m_cq_head;
+            const auto last = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != last; ++head, ++completed) {
+                const auto &cqe        = m_cqes[head & *m_cq_mask];
+                results[cqe.user_data] = cqe.res;
+            }
+            __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/// opens every file in one round trip and reads them in a second one. On
+/// kernels without IORING_OP_OPENAT the ring is left to the thread pool for
+/// good, and any other file the ring could not handle is read on the pool.
+static auto read_uring(std::vector<FileRead> &batch) -> bool {
+    static Ring ring(kRingDepth);
+    static bool openat = true;
+    if (!ring || !openat) return false;
+
+    std::vector<io_uring_sqe> ops(batch.size());
+    std::vector<int> fds;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        ops[i].opcode     = IORING_OP_OPENAT;
+        ops[i].fd         = AT_FDCWD;
+        ops[i].addr       = reinterpret_cast<uintptr_t>(batch[i].path);
+        ops[i].open_flags = O_RDONLY | O_CLOEXEC;
+    }
+    ring.run(ops, fds);
+    if (std::all_of(fds.begin(), fds.end(), [](int fd) { return fd == -EINVAL; })) return openat = false;
+
+    std::vector<size_t> opened;
+    ops.clear();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        auto &file = batch[i];
+        file.ok    = false;
+        if (fds[i] < 0) continue;
+        if (file.size > UINT32_MAX) {
+            ::close(fds[i]);
+            continue;
+        }
+
+        file.data.resize(file.size);
+        auto &op  = ops.emplace_back();
+        op.opcode = IORING_OP_READ;
+        op.fd     = fds[i];
+        op.addr   = reinterpret_cast<uintptr_t>(file.data.data());
+        op.len    = static_cast<uint32_t>(file.size);
+        opened.push_back(i);
+    }
+
+    std::vector<int> counts;
+    ring.run(ops, counts);
+
+    for (size_t j = 0; j < opened.size(); ++j) {
+        auto &file = batch[opened[j]];
+        file.ok    = counts[j] >= 0 && size_t(counts[j]) == file.size;
+        ::close(fds[opened[j]]);
+    }
+
+    std::vector<FileRead> failed;
+    for (auto &file : batch) {
+        if (!file.ok) failed.push_back(std::move(file));
+    }
+    read_threaded(failed);
+    for (size_t i = 0, j = 0; i < batch.size(); ++i) {
+        if (!batch[i].ok) batch[i] = std::move(failed[j++]);
+    }
+    return true;
+}
+#endif
+
+}  // namespace detail
+
+extern auto read_files(std::vector<FileRead> &batch) -> void {
+    if (batch.empty()) return;
+
+#if MCC_HAS_IO_URING
+    if (detail::read_uring(batch)) return;
+#endif
+    detail::read_threaded(batch);
+}
+
+}  // namespace mcc
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace mcc {
+
+/// FileRead
+/// ----------------------------------------------------------------------------
+/// One request of `read_files()`. `size` is the size the caller expects, e.g.
+/// from a previous stat, the read only succeeds if exactly that much is read.
+struct FileRead {
+    const char *path;
+    size_t size;
+    std::string data;
+    bool ok;
+};
+
+/// Opens and reads every file of `batch` at once. Uses io_uring when the
+/// kernel supports it and a small thread pool otherwise. A file that can not
+/// be read is only marked as not `ok`, reporting is left to the caller.
+extern auto read_files(std::vector<FileRead> &batch) -> void;
+
+}  // namespace mcc
\ No newline at end of file
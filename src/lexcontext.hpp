@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "srcmanager.hpp"
+#include "tokenbuffer.hpp"
+
+namespace mcc {
+
+/// TokenRange
+/// ----------------------------------------------------------------------------
+/// The tokens of one snippet lexed by `lex_batch()`, `size` tokens at
+/// `first`, without an `Eof`. Its values start at index `constants`,
+/// `symbols` and `literals` of the columns of the buffer. The last token is
+/// `None` if the snippet does not lex, see `lex_error_message()`.
+struct TokenRange {
+    size_t first;
+    size_t size;
+    size_t constants;
+    size_t symbols;
+    size_t literals;
+};
+
+/// LexContext
+/// ----------------------------------------------------------------------------
+/// Reusable state of `lex_batch()` for one thread. The snippets of a batch
+/// are copied into one arena, each behind a '\0' that ends the one before,
+/// and the source the context owns is re-pointed at the arena for every
+/// batch. The tokens of all the snippets go to one buffer. Each batch
+/// replaces the last one in place, so once the arenas have grown to the
+/// largest batch, lexing allocates nothing but new symbols and literals.
+/// Tokens and ranges are valid until the next batch.
+///
+/// The caller registers the source with `SourceManager::add()` and the
+/// context releases it when destroyed. Both may run on any thread while
+/// other contexts lex, as may the rebinding of a batch.
+class LexContext {
+public:
+    explicit LexContext(FileID file);
+    ~LexContext();
+    LexContext(LexContext &&)      = delete;
+    LexContext(const LexContext &) = delete;
+    auto operator=(LexContext &&) -> LexContext & = delete;
+    auto operator=(const LexContext &) -> LexContext & = delete;
+
+    inline auto file() const -> FileID { return m_file; }
+    inline auto tokens() const -> const TokenBuffer & { return m_tokens; }
+    inline auto ranges() const -> const std::vector<TokenRange> & { return m_ranges; }
+
+private:
+    friend auto lex_batch(LexContext &context, const std::vector<std::string_view> &snippets) -> void;
+
+    FileID m_file;
+    std::string m_source;  // '\0' and a snippet, for every snippet
+    TokenBuffer m_tokens;
+    std::vector<TokenRange> m_ranges;
+};
+
+}  // namespace mcc
@@ -1,142 +1,770 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
 #include <cstring>
-#include <unordered_map>
+#include <thread>
 #include <vector>
 
 #include "error.hpp"
+#include "mcc.hpp"
+#include "simd.hpp"
 #include "srcstream.hpp"
 #include "tkstream.hpp"
 #include "token.hpp"
+#include "tokencache.hpp"
 
 namespace mcc {
 
-static constexpr auto isident(int ch) -> bool { return isalnum(ch) || ch == '_' || ch == '$'; }
+/// Character classes
+/// ----------------------------------------------------------------------------
+/// What a token starting with a byte is, from a table built at compile time
+/// rather than the locale dependent <cctype> functions, so `lex_impl()` is a
+/// single lookup and switch. Blanks never get there, `skip_blank()` is past
+/// them, and the rest of a token is skipped by the `simd` functions.
+enum class Lead : uint8_t {
+    Invalid,
+    End,      // '\0'
+    Newline,  // '\n'
+    Slash,    // a comment or a punctuator
+    Ident,    // [A-Za-z_$]
+    Digit,    // [0-9]
+    Dot,      // a constant if a digit follows, else a punctuator
+    Str,      // '"'
+    Char,     // '\''
+    Punct,    // the rest of the ASCII punctuation
+    Unicode,  // >= 0x80, an identifier in a source that has them
+};
+
+static constexpr auto char_leads() -> std::array<Lead, 256> {
+    std::array<Lead, 256> leads{};
+    for (size_t ch = 0; ch < leads.size(); ++ch) {
+        if ((ch >= '!' && ch <= '/') || (ch >= ':' && ch <= '@') || (ch >= '[' && ch <= '`') || (ch >= '{' && ch <= '~')) leads[ch] = Lead::Punct;
+        if (((ch | 0x20) >= 'a' && (ch | 0x20) <= 'z') || ch == '_' || ch == '$') leads[ch] = Lead::Ident;
+        if (ch >= '0' && ch <= '9') leads[ch] = Lead::Digit;
+        if (ch >= 0x80) leads[ch] = Lead::Unicode;
+    }
+    leads['\0'] = Lead::End;
+    leads['\n'] = Lead::Newline;
+    leads['/']  = Lead::Slash;
+    leads['.']  = Lead::Dot;
+    leads['"']  = Lead::Str;
+    leads['\''] = Lead::Char;
+    return leads;
+}
+
+static constexpr auto kCharLeads = char_leads();
 
-static const std::unordered_map<std::string_view, TokenKind> kKeywords{
+static inline auto lead(char ch) -> Lead { return kCharLeads[static_cast<unsigned char>(ch)]; }
+
+/// Keywords
+/// ----------------------------------------------------------------------------
+/// A perfect hash over (first char, last char, length) built at compile time
+/// from inl/keyword.inl. Identifiers whose length or first char no keyword
+/// has are rejected before hashing, the rest cost a single compare.
+struct Keyword {
+    std::string_view spelling;
+    TokenKind kind;
+};
+
+static constexpr Keyword kKeywordList[]{
 #define MCC_DEFINE_KEYWORD(ENUM, STRING, VALUE) {STRING, TokenKind::ENUM},
 #include "inl/keyword.inl"
 #undef MCC_DEFINE_KEYWORD
 };
 
-static auto lex_impl(SrcStream &ss) -> Token;
+static constexpr size_t kKeywordBits  = 7;
+static constexpr size_t kKeywordSlots = size_t(1) << kKeywordBits;
+
+static constexpr auto keyword_hash(std::string_view ident, uint32_t seed) -> size_t {
+    const auto key = uint32_t(uint8_t(ident.front())) | uint32_t(uint8_t(ident.back())) << 8 | uint32_t(ident.size()) << 16;
+    return (key * seed) >> (32 - kKeywordBits);
+}
+
+/// first multiplier out of a pseudo-random sequence that maps every keyword
+/// to its own slot, consecutive odd numbers mix the keys too poorly.
+static constexpr auto keyword_seed() -> uint32_t {
+    uint32_t state = 1;
+    for (int i = 0; i < 100000; ++i) {
+        state           = state * 1664525 + 1013904223;
+        const auto seed = state | 1;
+
+        bool used[kKeywordSlots]{};
+        bool unique = true;
+        for (const auto &keyword : kKeywordList) {
+            auto &slot = used[keyword_hash(keyword.spelling, seed)];
+            unique     = unique && !slot;
+            slot       = true;
+        }
+        if (unique) return seed;
+    }
+    return 0;
+}
+
+static constexpr uint32_t kKeywordSeed = keyword_seed();
+static_assert(kKeywordSeed != 0, "no perfect hash for the keywords, raise kKeywordBits.");
+
+static constexpr auto keyword_table() -> std::array<Keyword, kKeywordSlots> {
+    std::array<Keyword, kKeywordSlots> table{};
+    for (auto &slot : table) slot = {"", TokenKind::Ident};
+    for (const auto &keyword : kKeywordList) table[keyword_hash(keyword.spelling, kKeywordSeed)] = keyword;
+    return table;
+}
+
+/// bit `n` set if some keyword is `n` chars long, or starts with 'a' + `n`
+static constexpr auto keyword_mask(bool length) -> uint32_t {
+    uint32_t mask = 0;
+    for (const auto &keyword : kKeywordList) {
+        mask |= uint32_t(1) << (length ? keyword.spelling.size() : keyword.spelling.front() - 'a');
+    }
+    return mask;
+}
+
+static constexpr auto kKeywordTable   = keyword_table();
+static constexpr auto kKeywordLengths = keyword_mask(true);
+static constexpr auto kKeywordFirsts  = keyword_mask(false);
+
+static auto find_keyword(std::string_view ident) -> TokenKind {
+    if (ident.size() >= 32 || !(kKeywordLengths >> ident.size() & 1)) return TokenKind::Ident;
+    if (uint8_t(ident.front() - 'a') >= 26 || !(kKeywordFirsts >> (ident.front() - 'a') & 1)) return TokenKind::Ident;
+
+    const auto &slot = kKeywordTable[keyword_hash(ident, kKeywordSeed)];
+    return slot.spelling == ident ? slot.kind : TokenKind::Ident;
+}
+
+/// Punctuators
+/// ----------------------------------------------------------------------------
+/// A dense longest-match DFA built at compile time from inl/punctuator.inl.
+/// The states are the prefixes of the punctuators, state 0 the empty one.
+/// Bytes that occur in no punctuator share class 0, which has no transition,
+/// so the '\0' sentinel ends every match.
+struct Punctuator {
+    std::string_view spelling;
+    TokenKind kind;
+};
+
+static constexpr Punctuator kPunctList[]{
+#define MCC_DEFINE_PUNCTUATOR(ENUM, STRING, VALUE) {STRING, TokenKind::ENUM},
+#include "inl/punctuator.inl"
+#undef MCC_DEFINE_PUNCTUATOR
+};
+
+static constexpr auto punct_classes() -> std::array<uint8_t, 256> {
+    std::array<uint8_t, 256> classes{};
+    uint8_t count = 0;
+    for (const auto &punct : kPunctList) {
+        for (const auto ch : punct.spelling) {
+            if (classes[uint8_t(ch)] == 0) classes[uint8_t(ch)] = ++count;
+        }
+    }
+    return classes;
+}
+
+static constexpr auto kPunctClasses = punct_classes();
+
+/// class 0 plus one class per distinct byte
+static constexpr auto punct_class_count() -> size_t {
+    size_t count = 0;
+    for (const auto cls : kPunctClasses) count = cls > count ? cls : count;
+    return count + 1;
+}
+
+/// the empty prefix plus at most one state per byte of every punctuator
+static constexpr auto punct_state_bound() -> size_t {
+    size_t count = 1;
+    for (const auto &punct : kPunctList) count += punct.spelling.size();
+    return count;
+}
+
+static constexpr size_t kPunctClassNum = punct_class_count();
+static constexpr size_t kPunctStateMax = punct_state_bound();
+static_assert(kPunctStateMax <= 256, "too many punctuator prefixes for 8-bit states.");
+
+struct PunctDfa {
+    std::array<std::array<uint8_t, kPunctClassNum>, kPunctStateMax> next;  // 0 if there is no transition
+    std::array<TokenKind, kPunctStateMax> accept;
+    std::array<bool, kPunctStateMax> accepting;
+};
+
+static constexpr auto punct_dfa() -> PunctDfa {
+    PunctDfa dfa{};
+    size_t states = 1;
+    for (const auto &punct : kPunctList) {
+        size_t state = 0;
+        for (const auto ch : punct.spelling) {
+            auto &next = dfa.next[state][kPunctClasses[uint8_t(ch)]];
+            if (next == 0) next = uint8_t(states++);
+            state = next;
+        }
+        dfa.accept[state]    = punct.kind;
+        dfa.accepting[state] = true;
+    }
+    return dfa;
+}
+
+static constexpr auto kPunctDfa = punct_dfa();
+
+/// Errors
+/// ----------------------------------------------------------------------------
+/// An error travels as a `None` token whose length indexes `kLexErrors`, so a
+/// chunk lexed by `lex_parallel()` from a wrong guess can drop it. Whoever
+/// hands the token on reports it with `report()`, but `relex()` and
+/// `lex_batch()` leave it in their tokens, see `lex_error_message()`.
+enum LexError : uint32_t {
+    kLiteralTerminator,
+    kUnknownPunctuator,
+    kCommentTerminator,
+    kInvalidToken,
+    kInvalidConstant,
+    kInvalidEscape,
+    kTokenTooLong,
+    kInvalidUtf8,
+    kNullCharacter,
+};
+
+static constexpr const char *kLexErrors[] = {
+    "expect literal terminator.",
+    "unknown punctuator.",
+    "expect comment terminator `*/`.",
+    "invalid token.",
+    "invalid constant.",
+    "invalid escape sequence.",
+    "token too long.",
+    "invalid UTF-8 sequence.",
+    "null character in snippet.",
+};
+
+static auto lex_error(LexError error, SrcLoc loc) -> Token { return {TokenKind::None, error, 0, loc}; }
+
+[[noreturn]] static auto report(const Token &token) -> void { panic(kLexErrors[token.length], token.loc); }
+
+extern auto lex_error_message(const Token &token) -> const char * {
+    return kLexErrors[token.length];
+}
+
+static auto make_token(SrcStream &ss, TokenKind kind, SrcLoc loc) -> Token {
+    const auto length = ss.location().offset - loc.offset;
+    if (length > Token::kMaxLength) return lex_error(kTokenTooLong, loc);
+    return Token{kind, length, 0, loc};
+}
 
 static auto lex_literal(SrcStream &ss, SrcLoc loc, TokenKind kind, char term) -> Token {
-    const auto first = ss.location().current;
+    bool terminated = true;
     ss.skip([&](char ch) {
-        if (ch == '\\') (++ss).match(term);
-        if (ch == '\0') panic("expect literal terminator.", ss.location());
+        if (ch == '\\') {
+            // an escaped sentinel still ends the source
+            if (*(++ss).current() == '\0') return terminated = false;
+            ss.match(term);
+        }
+        if (ch == '\0') return terminated = false;
         return !ss.match(term);
     });
-    const auto last = ss.location().current - 1;
-    return Token{kind, {first, last}, loc};
+    if (!terminated) return lex_error(kLiteralTerminator, ss.location());
+    return make_token(ss, kind, loc);
 }
+/// `None` if no punctuator starts at `ss`
 static auto lex_punct_impl(SrcStream &ss) -> TokenKind {
-    const int ch = *ss++;
-    switch (ch) {
-        case '(': return TokenKind::LParen;
-        case ')': return TokenKind::RParen;
-        case '{': return TokenKind::LBrace;
-        case '}': return TokenKind::RBrace;
-        case '[': return TokenKind::LBracket;
-        case ']': return TokenKind::RBracket;
-        case ';': return TokenKind::Semicolon;
-        case ',': return TokenKind::Comma;
-        case ':': return TokenKind::Colon;
-        case '?': return TokenKind::Ques;
-        case '~': return TokenKind::BitNot;
-        case '.': return ss.match('.', '.') ? TokenKind::Ellipsis : TokenKind::Dot;
-        case '#': return ss.match('#') ? TokenKind::DSharp : TokenKind::Sharp;
-        case '*': return ss.match('=') ? TokenKind::MulAssign : TokenKind::Mul;
-        case '%': return ss.match('=') ? TokenKind::ModAssign : TokenKind::Mod;
-        case '/': return ss.match('=') ? TokenKind::DivAssign : TokenKind::Div;
-        case '=': return ss.match('=') ? TokenKind::Equal : TokenKind::Assign;
-        case '!': return ss.match('=') ? TokenKind::NotEqual : TokenKind::Not;
-        case '^': return ss.match('=') ? TokenKind::XorAssign : TokenKind::BitXor;
-        case '&':
-            if (ss.match('=')) return TokenKind::AndAssign;
-            if (ss.match('&')) return TokenKind::And;
-            return TokenKind::BitAnd;
-        case '|':
-            if (ss.match('=')) return TokenKind::OrAssign;
-            if (ss.match('|')) return TokenKind::Or;
-            return TokenKind::BitOr;
-        case '+':
-            if (ss.match('=')) return TokenKind::AddAssign;
-            if (ss.match('+')) return TokenKind::Increase;
-            return TokenKind::Add;
-        case '-':
-            if (ss.match('=')) return TokenKind::SubAssign;
-            if (ss.match('-')) return TokenKind::Decrease;
-            if (ss.match('>')) return TokenKind::Arrow;
-            return TokenKind::Sub;
-        case '<':
-            if (ss.match('<', '=')) return TokenKind::ShlAssign;
-            if (ss.match('<')) return TokenKind::BitShl;
-            if (ss.match('=')) return TokenKind::LessEqual;
-            return TokenKind::Less;
-        case '>':
-            if (ss.match('>', '=')) return TokenKind::ShrAssign;
-            if (ss.match('>')) return TokenKind::BitShr;
-            if (ss.match('=')) return TokenKind::GreaterEqual;
-            return TokenKind::Greater;
-        default:
-            panic("unknown punctuator.", ss.location());
+    const auto first = ss.current();
+
+    size_t state = 0, length = 0;
+    auto kind    = TokenKind::Ident;
+    for (size_t i = 0; (state = kPunctDfa.next[state][kPunctClasses[uint8_t(first[i])]]); ++i) {
+        if (kPunctDfa.accepting[state]) kind = kPunctDfa.accept[state], length = i + 1;
     }
+
+    if (length == 0) return TokenKind::None;
+    ss += length;
+    return kind;
 }
 static auto lex_punct(SrcStream &ss, SrcLoc loc) -> Token {
-    // line comment
-    if (ss.match('/', '/')) {
-        ss.skip([&](char ch) { return ch && !ss.match('\n'); });
-        return lex_impl(ss);
+    const auto kind = lex_punct_impl(ss);
+    if (kind == TokenKind::None) return lex_error(kUnknownPunctuator, ss.location());
+    return make_token(ss, kind, loc);
+}
+static auto lex_const(SrcStream &ss, SrcLoc loc) -> Token {
+    // a sign right after an exponent continues the constant, as in `1e+5`
+    const auto exponent = [](char ch) { return (ch | 0x20) == 'e' || (ch | 0x20) == 'p'; };
+    for (ss.skip_number(); exponent(ss.current()[-1]) && (*ss == '+' || *ss == '-'); ss.skip_number()) ++ss;
+    return make_token(ss, TokenKind::Const, loc);
+}
+static auto lex_ident(SrcStream &ss, SrcLoc loc) -> Token {
+    const auto first = ss.current();
+    ss.skip_ident();
+    const auto last = ss.current();
+    return make_token(ss, find_keyword({first, size_t(last - first)}), loc);
+}
+/// skips blanks, newlines and comments, then lexes a token. A token starts
+/// a line after a newline or a line comment, a block comment does not end
+/// its line.
+static auto lex_impl(SrcStream &ss) -> Token {
+    uint8_t flags = ss.location().offset == 0 ? kLineStart : 0;
+    for (;;) {
+        ss.skip_blank();
+        const auto loc = ss.location();
+
+        Token token;
+        switch (lead(*ss)) {
+            case Lead::End: token = {TokenKind::Eof, 0, 0, loc}; break;
+            case Lead::Newline:
+                ++ss;
+                flags = kLineStart;
+                continue;
+            case Lead::Slash:
+                if (ss.match('/', '/')) {
+                    ss.skip_line_comment();
+                    flags = kLineStart;
+                    continue;
+                }
+                if (ss.match('/', '*')) {
+                    if (!ss.skip_block_comment()) return lex_error(kCommentTerminator, ss.location());
+                    continue;
+                }
+                token = lex_punct(ss, loc);
+                break;
+            case Lead::Ident: token = lex_ident(ss, loc); break;
+            case Lead::Digit: token = lex_const(ss, loc); break;
+            case Lead::Dot: token = lead(ss.current()[1]) == Lead::Digit ? lex_const(ss, loc) : lex_punct(ss, loc); break;
+            case Lead::Str: token = lex_literal(++ss, loc, TokenKind::Str, '\"'); break;
+            case Lead::Char: token = lex_literal(++ss, loc, TokenKind::Char, '\''); break;
+            case Lead::Punct: token = lex_punct(ss, loc); break;
+            case Lead::Unicode:
+                if (ss.ascii()) return lex_error(kInvalidToken, loc);
+                token = lex_ident(ss, loc);
+                break;
+            case Lead::Invalid: return lex_error(kInvalidToken, loc);
+        }
+        if (token.kind != TokenKind::None) token.flags = flags;
+        return token;
     }
+}
+/// Constants
+/// ----------------------------------------------------------------------------
+/// Integers are decoded with the C rules for their base and suffix, floating
+/// constants with `std::from_chars()`. The C type is the first of the
+/// candidates for the suffix the value fits in.
+static auto decode_integer(const char *first, const char *last, Constant &constant) -> bool {
+    constexpr ConstantType kTypes[] = {
+        ConstantType::Int, ConstantType::UnsignedInt, ConstantType::Long, ConstantType::UnsignedLong, ConstantType::LongLong, ConstantType::UnsignedLongLong,
+    };
+    constexpr uint64_t kMax[] = {INT32_MAX, UINT32_MAX, INT64_MAX, UINT64_MAX, INT64_MAX, UINT64_MAX};
 
-    // block comment
-    if (ss.match('/', '*')) {
-        ss.skip([&](char ch) {
-            if (!ch) panic("expect comment terminator `*/`.", ss.location());
-            return !ss.match('*', '/');
-        });
-        return lex_impl(ss);
+    int base = 10;
+    if (last - first > 2 && first[0] == '0' && (first[1] | 0x20) == 'x') {
+        base = 16, first += 2;
+    } else if (first[0] == '0') {
+        base = 8;
     }
 
-    if (ss.match('\"')) return lex_literal(ss, loc, TokenKind::Str, '\"');
-    if (ss.match('\'')) return lex_literal(ss, loc, TokenKind::Char, '\'');
-    const auto first = ss.location().current;
-    const auto kind  = lex_punct_impl(ss);
-    const auto last  = ss.location().current;
-    return Token{kind, {first, last}, loc};
+    uint64_t value    = 0;
+    auto [suffix, ec] = std::from_chars(first, last, value, base);
+    if (ec != std::errc()) return false;
+
+    // u, l, ll in either order and case, but not `lL`
+    bool is_unsigned = false;
+    size_t longs     = 0;
+    while (suffix != last) {
+        if ((*suffix | 0x20) == 'u' && !is_unsigned) {
+            is_unsigned = true, suffix += 1;
+        } else if ((*suffix | 0x20) == 'l' && longs == 0) {
+            longs = suffix + 1 != last && suffix[1] == suffix[0] ? 2 : 1;
+            suffix += longs;
+        } else {
+            return false;
+        }
+    }
+
+    // decimal constants without `u` stay signed, the others may turn unsigned
+    const size_t step = is_unsigned || base == 10 ? 2 : 1;
+    size_t index      = longs * 2 + is_unsigned;
+    while (index + step < std::size(kTypes) && value > kMax[index]) index += step;
+
+    constant.type    = value > kMax[index] ? ConstantType::UnsignedLongLong : kTypes[index];
+    constant.integer = value;
+    return true;
 }
-static auto lex_const(SrcStream &ss, SrcLoc loc) -> Token {
-    const auto first = ss.location().current;
-    ss.skip([](char ch) { return isident(ch) || ch == '.'; });
-    const auto last = ss.location().current;
-    return Token{TokenKind::Const, {first, last}, loc};
+
+static auto decode_floating(const char *first, const char *last, Constant &constant) -> bool {
+    constant.type = ConstantType::Double;
+    if ((last[-1] | 0x20) == 'f') constant.type = ConstantType::Float, --last;
+    else if ((last[-1] | 0x20) == 'l') constant.type = ConstantType::LongDouble, --last;
+
+    auto format = std::chars_format::general;
+    if (last - first > 2 && first[0] == '0' && (first[1] | 0x20) == 'x') {
+        // a hexadecimal floating constant needs its binary exponent
+        if (std::find_if(first, last, [](char ch) { return (ch | 0x20) == 'p'; }) == last) return false;
+        format = std::chars_format::hex, first += 2;
+    }
+
+    auto [end, ec] = std::from_chars(first, last, constant.floating, format);
+    return ec == std::errc() && end == last;
 }
-static auto lex_ident(SrcStream &ss, SrcLoc loc) -> Token {
-    const auto first = ss.location().current;
-    ss.skip(isident);
-    const auto last  = ss.location().current;
-    const auto ident = std::string_view(first, last - first);
-    const auto iter  = kKeywords.find(ident);
-    return Token{iter == kKeywords.end() ? TokenKind::Ident : iter->second, {first, last}, loc};
+
+/// decodes the spelling of a `Const` token, false if it is no valid constant
+static auto decode_const(std::string_view text, Constant &constant) -> bool {
+    // most constants are short decimal ints, which always fit in an `int`
+    const auto digit = [](char ch) { return ch >= '0' && ch <= '9'; };
+    if (text.size() < 10 && (text[0] != '0' || text.size() == 1) && std::all_of(text.begin(), text.end(), digit)) {
+        constant.type    = ConstantType::Int;
+        constant.integer = 0;
+        for (auto ch : text) constant.integer = constant.integer * 10 + (ch - '0');
+        return true;
+    }
+
+    const auto hex      = text.size() > 2 && text[0] == '0' && (text[1] | 0x20) == 'x';
+    const auto floating = text.find_first_of(hex ? ".pP" : ".eE") != std::string_view::npos;
+    if (floating) return decode_floating(text.data(), text.data() + text.size(), constant);
+    return decode_integer(text.data(), text.data() + text.size(), constant);
 }
-static auto lex_impl(SrcStream &ss) -> Token {
-    ss.skip([](int ch) { return ch == ' ' || ch == '\t'; });
-    auto loc = ss.location();
-    if (!ss) return {TokenKind::Eof, "", loc};
-    if (ss.match('\n')) return {TokenKind::Line, "", loc};
-    if (isdigit(*ss))
-        return lex_const(ss, loc);
-    if (isident(*ss)) return lex_ident(ss, loc);
-    if (ispunct(*ss)) return lex_punct(ss, loc);
-    panic("invalid token.", ss.location());
-}
-extern auto lex(SrcStream &&_ss) -> TkStream {
-    auto ss = _ss;
-    std::vector<Token> result;
-
-    result.emplace_back(TokenKind::Line, "", ss.location());
-    while (ss) result.push_back(lex_impl(ss));
-    return TkStream(std::move(result));
+
+/// interns the bytes of a literal, most have no escapes and need no copy
+static auto intern_literal(std::string_view text, Literal &literal) -> bool {
+    if (text.find('\\') == std::string_view::npos) {
+        literal = Literal::intern(text);
+        return true;
+    }
+
+    thread_local std::string bytes;
+    if (!decode_literal(text, bytes)) return false;
+    literal = Literal::intern(bytes);
+    return true;
+}
+
+/// lexes a token, decodes a `Const` or a literal and interns an `Ident` into
+/// `value`
+static auto lex_next(SrcStream &ss, TokenValue &value) -> Token {
+    const auto token = lex_impl(ss);
+    if (!has_value(token.kind)) return token;
+
+    const auto text = std::string_view(ss.current() - token.length, token.length);
+    if (token.kind == TokenKind::Ident) {
+        value.symbol = Symbol::intern(text);
+    } else if (token.kind == TokenKind::Const) {
+        if (!decode_const(text, value.constant)) return lex_error(kInvalidConstant, token.loc);
+    } else if (!intern_literal(text.substr(1, text.size() - 2), value.literal)) {
+        return lex_error(kInvalidEscape, token.loc);
+    }
+    return token;
+}
+
+/// lexes a token as `lex_next()` does, but a token that reaches `limit`, e.g.
+/// the first byte of an invalid UTF-8 sequence, is `error` there
+static auto lex_until(SrcStream &ss, TokenValue &value, uint32_t limit, LexError error = kInvalidUtf8) -> Token {
+    const auto token = lex_next(ss, value);
+
+    // the length of an error is its kind, `Eof` has none
+    const auto none = token.kind == TokenKind::None || token.kind == TokenKind::Eof;
+    const auto last = none ? token.loc.offset : token.loc.offset + token.length - 1;
+    if (last >= limit) return lex_error(error, {ss.file(), limit});
+    return token;
+}
+
+/// lexes one token each time the token stream asks for one
+class Lexer : public TokenSource {
+public:
+    Lexer(SrcStream &&ss) : m_ss(std::move(ss)), m_invalid(SourceManager::instance().invalid(m_ss.file())) {}
+
+    auto next() -> Token override {
+        const auto token = lex_until(m_ss, m_value, m_invalid);
+        if (token.kind == TokenKind::None) report(token);
+
+        // the window of a streamed source is gone after the next refill.
+        // Identifiers and literals are interned, only the spelling of a
+        // constant is still needed, as `AstExprConstant` prints it.
+        if (m_ss.streaming() && token.kind == TokenKind::Const) SourceManager::instance().keep(token.loc, token.length);
+        return token;
+    }
+    auto value() const -> TokenValue override { return m_value; }
+
+private:
+    SrcStream m_ss;
+    uint32_t m_invalid;  // see `SourceManager::invalid()`
+    TokenValue m_value;
+};
+
+/// Parallel lexing
+/// ----------------------------------------------------------------------------
+/// The buffer is cut into chunks after a newline and every chunk is lexed on
+/// its own, guessing that it starts outside of any comment or literal unless
+/// its first `*/` comes before its first `/*`. As the lexer has no state but
+/// the position, a chunk is right from the first token boundary it shares
+/// with the chunk before. `fix_up()` splices the chunks at those boundaries
+/// and re-lexes only up to the next one.
+namespace detail {
+
+constexpr size_t kChunkMin    = size_t(256) << 10;
+constexpr size_t kParallelMin = size_t(4) << 20;
+
+struct Chunk {
+    uint32_t begin;      // first byte of the chunk
+    uint32_t end;        // first byte of the next chunk
+    uint32_t start;      // where the guess starts lexing
+    uint32_t stop;       // where lexing stopped, at or past `end`
+    TokenBuffer tokens;  // the last one is `None` if lexing ran into an error
+};
+
+/// where the lexer stands after `tokens[index]`
+static auto token_end(const TokenBuffer &tokens, size_t index) -> uint32_t {
+    return tokens.loc(index).offset + tokens.length(index);
+}
+
+static auto guess_start(const char *data, uint32_t begin, uint32_t end) -> uint32_t {
+    const std::string_view chunk(data + begin, end - begin);
+    const auto close = chunk.find("*/");
+    if (close == std::string_view::npos || chunk.find("/*") < close) return begin;
+    return begin + static_cast<uint32_t>(close + 2);
+}
+
+static auto lex_chunk(FileID file, Chunk &chunk) -> void {
+    auto ss = SrcStream(file);
+    ss.reset({file, chunk.start});
+
+    TokenValue value;
+    chunk.stop = chunk.start;
+    while (chunk.stop < chunk.end) {
+        const auto token = lex_next(ss, value);
+        if (token.kind == TokenKind::Eof) {
+            chunk.stop = token.loc.offset;
+            break;
+        }
+        chunk.tokens.push_back(token, value);
+        if (token.kind == TokenKind::None) break;
+        chunk.stop = token.loc.offset + token.length;
+    }
+}
+
+/// appends the tokens of `chunk` to `result`, lexing from `pos`, where the
+/// chunk before stopped, until a boundary of the guess is met.
+static auto fix_up(FileID file, uint32_t pos, const Chunk &chunk, TokenBuffer &result) -> uint32_t {
+    const auto &tokens = chunk.tokens;
+    const auto failed  = !tokens.empty() && tokens.kind(tokens.size() - 1) == TokenKind::None;
+    const auto count   = tokens.size() - failed;
+
+    // index of the token the guess lexed from `pos`, `npos` if none did
+    const auto guessed = [&](uint32_t pos) -> size_t {
+        if (pos == chunk.start) return 0;
+        size_t low = 0, high = count;
+        while (low < high) {
+            const auto mid = (low + high) / 2;
+            if (token_end(tokens, mid) < pos) low = mid + 1;
+            else high = mid;
+        }
+        return low < count && token_end(tokens, low) == pos ? low + 1 : std::string_view::npos;
+    };
+
+    TokenValue value;
+    auto ss = SrcStream(file);
+    ss.reset({file, pos});
+    for (;;) {
+        if (auto first = guessed(pos); first != std::string_view::npos) {
+            if (failed && first < tokens.size()) report(tokens[tokens.size() - 1]);
+            result.append(tokens, first);
+            return chunk.stop;
+        }
+        if (pos >= chunk.end) return pos;
+
+        const auto token = lex_next(ss, value);
+        if (token.kind == TokenKind::Eof) return token.loc.offset;
+        if (token.kind == TokenKind::None) report(token);
+        result.push_back(token, value);
+        pos = token.loc.offset + token.length;
+    }
+}
+
+}  // namespace detail
+
+extern auto lex_parallel(FileID file, size_t threads) -> TokenBuffer {
+    const auto data = SourceManager::instance().buffer(file).data();
+    const auto size = static_cast<uint32_t>(SourceManager::instance().buffer(file).size());
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // a few chunks per thread even out their different costs
+    const auto count = std::clamp<size_t>(size / detail::kChunkMin, 1, threads * 4);
+
+    std::vector<detail::Chunk> chunks;
+    for (uint32_t begin = 0; begin < size;) {
+        auto end = static_cast<uint32_t>(std::min<size_t>(begin + size / count, size));
+        if (auto eol = static_cast<const char *>(std::memchr(data + end, '\n', size - end)); end < size) {
+            end = eol ? static_cast<uint32_t>(eol - data + 1) : size;
+        }
+        const auto start = begin == 0 ? 0 : detail::guess_start(data, begin, end);
+        chunks.push_back({begin, end, start, start, {}});
+        begin = end;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&chunks, &next, file] {
+        for (size_t i; (i = next++) < chunks.size();) detail::lex_chunk(file, chunks[i]);
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < std::min(threads, chunks.size()); ++i) pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool) thread.join();
+
+    size_t total = 0;
+    for (const auto &chunk : chunks) total += chunk.tokens.size();
+
+    TokenBuffer result;
+    result.reserve(total);
+    uint32_t pos = 0;
+    for (const auto &chunk : chunks) pos = detail::fix_up(file, pos, chunk, result);
+    return result;
+}
+
+/// Incremental lexing
+/// ----------------------------------------------------------------------------
+/// `tokens` are all the tokens of `file` before `edit`, which was applied to
+/// it with `SourceManager::update()`. As the lexer has no state but the
+/// position, the old tokens stay right up to the last one that ends before
+/// the edit, and again from the first old token end past the edit that the
+/// new tokens meet. Only the tokens in between are lexed, the ones after
+/// them are moved by the length the edit added or removed. A lex error, an
+/// invalid UTF-8 sequence too, ends `tokens` with its `None` token rather
+/// than stop the process, and the next edit lexes on from there.
+extern auto relex(TokenBuffer &tokens, FileID file, const SrcEdit &edit) -> TokenDiff {
+    const auto delta    = static_cast<int64_t>(edit.inserted.size()) - edit.removed;
+    const auto inserted = static_cast<uint32_t>(edit.offset + edit.inserted.size());
+
+    // an error ends the tokens, nothing after it was lexed
+    const auto failed = !tokens.empty() && tokens.kind(tokens.size() - 1) == TokenKind::None;
+    const auto count  = tokens.size() - failed;
+
+    // the first token that ends at or after the edit may change, it could
+    // also just grow by the inserted text
+    size_t first = 0, high = count;
+    while (first < high) {
+        const auto mid = (first + high) / 2;
+        if (detail::token_end(tokens, mid) < edit.offset) first = mid + 1;
+        else high = mid;
+    }
+
+    auto ss = SrcStream(file);
+    ss.reset({file, first == 0 ? 0 : detail::token_end(tokens, first - 1)});
+
+    TokenBuffer fresh;
+    TokenValue value;
+    const auto invalid = SourceManager::instance().invalid(file);
+    auto last          = first;  // old tokens up to here are replaced
+    for (;;) {
+        const auto token = lex_until(ss, value, invalid);
+        if (token.kind == TokenKind::Eof) {
+            last = tokens.size();
+            break;
+        }
+        fresh.push_back(token, value);
+        if (token.kind == TokenKind::None) {
+            last = tokens.size();
+            break;
+        }
+
+        const auto end = token.loc.offset + token.length;
+        if (end < inserted) continue;
+
+        // past the edit, in the offsets of the old source
+        const auto old_end = static_cast<uint32_t>(end - delta);
+        while (last < count && detail::token_end(tokens, last) < old_end) ++last;
+        if (last < count && detail::token_end(tokens, last) == old_end) {
+            ++last;
+            break;
+        }
+    }
+
+    tokens.replace(first, last, fresh);
+    tokens.move_to(file, first + fresh.size(), delta);
+    return {first, last - first, fresh.size()};
+}
+
+/// Batch lexing
+/// ----------------------------------------------------------------------------
+/// Many small snippets are lexed into the arenas of a `LexContext` rather
+/// than a source and a token buffer each. The '\0' in front of the next
+/// snippet is the sentinel the lexer stops at, as at the end of a buffer. A
+/// '\0' inside of a snippet is an error. A snippet that does not lex
+/// ends its range with the `None` token of its error, and the next snippet
+/// is lexed as usual.
+LexContext::LexContext(FileID file) : m_file(file) {}
+
+LexContext::~LexContext() { SourceManager::instance().release(m_file); }
+
+/// a snippet without its byte order mark, as `SrcBuffer` drops the one of a
+/// source
+static auto skip_bom(std::string_view snippet) -> std::string_view {
+    return snippet.substr(snippet.compare(0, 3, "\xef\xbb\xbf") == 0 ? 3 : 0);
+}
+
+/// the first token of a snippet starts a line, as the first one of a source.
+/// An invalid UTF-8 sequence is found for the whole batch, and only again
+/// past a snippet that has one.
+extern auto lex_batch(LexContext &context, const std::vector<std::string_view> &snippets) -> void {
+    auto &source = context.m_source;
+    auto &tokens = context.m_tokens;
+    auto &ranges = context.m_ranges;
+
+    source.clear();
+    for (const auto &snippet : snippets) {
+        source.push_back('\0');
+        source.append(skip_bom(snippet));
+    }
+    SourceManager::instance().rebind(context.m_file, source.c_str(), source.size());
+
+    tokens.clear();
+    ranges.clear();
+
+    auto ss      = SrcStream(context.m_file);
+    auto offset  = uint32_t(0);
+    auto invalid = SourceManager::instance().invalid(context.m_file);
+    TokenValue value;
+    for (const auto &snippet : snippets) {
+        ranges.push_back({tokens.size(), 0, tokens.constants().size(), tokens.symbols().size(), tokens.literals().size()});
+        ss.reset({context.m_file, ++offset});
+        if (invalid < offset) {
+            bool ascii;
+            const auto bad = simd::validate_utf8(source.data() + offset, source.size() - offset, ascii);
+            invalid        = offset + bad == source.size() ? UINT32_MAX : static_cast<uint32_t>(offset + bad);
+        }
+
+        // a '\0' would end the snippet early
+        const auto text = skip_bom(snippet);
+        const auto nul  = text.find('\0');
+        const auto stop = nul == std::string_view::npos || offset + nul >= invalid ? invalid : static_cast<uint32_t>(offset + nul);
+        for (;;) {
+            auto token = lex_until(ss, value, stop, stop == invalid ? kInvalidUtf8 : kNullCharacter);
+            if (token.kind == TokenKind::Eof) break;
+            if (token.kind != TokenKind::None && tokens.size() == ranges.back().first) token.flags |= kLineStart;
+            tokens.push_back(token, value);
+            if (token.kind == TokenKind::None) break;
+        }
+        ranges.back().size = tokens.size() - ranges.back().first;
+        offset += static_cast<uint32_t>(text.size());
+    }
+}
+
+/// a large file on a multi-core host is lexed in parallel up front, anything
+/// else as the token stream asks for it. With the token cache on, a whole
+/// file is read from the cache or lexed up front and stored there. A file
+/// an edit left with an invalid UTF-8 sequence is lexed one token at a time,
+/// so the sequence is reported when the lexer gets to it.
+extern auto lex(SrcStream &&ss) -> TkStream {
+    if (ss.streaming() || ss.location().offset != 0 || SourceManager::instance().invalid(ss.file()) != UINT32_MAX) {
+        return TkStream(std::make_unique<Lexer>(std::move(ss)));
+    }
+
+    const auto file     = ss.file();
+    const auto parallel = std::thread::hardware_concurrency() > 1 && SourceManager::instance().buffer(file).size() >= detail::kParallelMin;
+    if (token_cache_enabled()) {
+        TokenBuffer tokens;
+        if (load_tokens(file, tokens)) return TkStream(std::move(tokens));
+
+        tokens = parallel ? lex_parallel(file) : TkStream(std::make_unique<Lexer>(std::move(ss))).collect();
+        store_tokens(file, tokens);
+        return TkStream(std::move(tokens));
+    }
+    if (parallel) return TkStream(lex_parallel(file));
+    return TkStream(std::make_unique<Lexer>(std::move(ss)));
+}
+
+extern auto lex(std::string_view source, std::string srcfile) -> TkStream {
+    return lex(SrcStream(source, std::move(srcfile)));
 }
 
 }  // namespace mcc
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "literal.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "error.hpp"
+#include "simd.hpp"
+
+namespace mcc {
+
+namespace detail {
+
+constexpr size_t kBlockSize = size_t(64) << 10;
+
+/// FNV-1a
+static auto hash(std::string_view bytes) -> uint32_t {
+    uint32_t result = 2166136261u;
+    for (auto ch : bytes) result = (result ^ static_cast<unsigned char>(ch)) * 16777619u;
+    return result;
+}
+
+/// LiteralPool
+/// ----------------------------------------------------------------------------
+/// The bytes of all literals in fixed blocks, with an open addressed table
+/// over them to find a literal that is already there. An id is an index into
+/// the entries, index 0 is the empty literal.
+class LiteralPool {
+public:
+    static auto instance() -> LiteralPool &;
+
+    auto intern(std::string_view bytes) -> uint32_t;
+    auto bytes(uint32_t id) -> std::string_view;
+
+private:
+    LiteralPool();
+
+    struct Entry {
+        const char *data;
+        uint32_t length;
+        uint32_t hash;
+    };
+
+    auto store(std::string_view bytes) -> const char *;
+    auto grow() -> void;
+
+    std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_slots;  // index into `m_entries` + 1, 0 if free
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    size_t m_used = kBlockSize;  // bytes used in `m_blocks.back()`
+};
+
+auto LiteralPool::instance() -> LiteralPool & {
+    static LiteralPool pool;
+    return pool;
+}
+
+LiteralPool::LiteralPool() : m_slots(1024, 0) {
+    m_entries.push_back({"", 0, hash({})});
+}
+
+/// bytes longer than a block get a block of their own, put in front of the
+/// one being filled so that one stays `m_blocks.back()`
+auto LiteralPool::store(std::string_view bytes) -> const char * {
+    if (bytes.size() > kBlockSize) {
+        auto iter = m_blocks.emplace(m_blocks.empty() ? m_blocks.end() : m_blocks.end() - 1, new char[bytes.size()]);
+        std::copy(bytes.begin(), bytes.end(), iter->get());
+        return iter->get();
+    }
+    if (bytes.size() > kBlockSize - m_used) {
+        m_blocks.emplace_back(new char[kBlockSize]);
+        m_used = 0;
+    }
+    auto result = m_blocks.back().get() + m_used;
+    std::copy(bytes.begin(), bytes.end(), result);
+    m_used += bytes.size();
+    return result;
+}
+
+auto LiteralPool::grow() -> void {
+    m_slots.assign(m_slots.size() * 2, 0);
+    const auto mask = m_slots.size() - 1;
+    for (uint32_t index = 1; index < m_entries.size(); ++index) {
+        auto slot = m_entries[index].hash & mask;
+        while (m_slots[slot]) slot = (slot + 1) & mask;
+        m_slots[slot] = index + 1;
+    }
+}
+
+auto LiteralPool::intern(std::string_view bytes) -> uint32_t {
+    if (bytes.size() > UINT32_MAX) panic("literal too long");
+    const auto code = hash(bytes);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto mask = m_slots.size() - 1;
+    auto slot       = code & mask;
+    for (; m_slots[slot]; slot = (slot + 1) & mask) {
+        const auto index  = m_slots[slot] - 1;
+        const auto &entry = m_entries[index];
+        if (entry.hash == code && std::string_view(entry.data, entry.length) == bytes) return index;
+    }
+
+    const auto index = static_cast<uint32_t>(m_entries.size());
+    m_entries.push_back({store(bytes), static_cast<uint32_t>(bytes.size()), code});
+    m_slots[slot] = index + 1;
+    if (m_entries.size() * 2 > m_slots.size()) grow();
+    return index;
+}
+
+auto LiteralPool::bytes(uint32_t id) -> std::string_view {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto &entry = m_entries[id];
+    return {entry.data, entry.length};
+}
+
+static auto hex_value(char ch) -> int {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if ((ch | 0x20) >= 'a' && (ch | 0x20) <= 'f') return (ch | 0x20) - 'a' + 10;
+    return -1;
+}
+
+/// appends the code point `code` as UTF-8
+static auto append_utf8(std::string &bytes, uint32_t code) -> void {
+    if (code < 0x80) {
+        bytes += static_cast<char>(code);
+    } else if (code < 0x800) {
+        bytes += static_cast<char>(0xc0 | code >> 6);
+        bytes += static_cast<char>(0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        bytes += static_cast<char>(0xe0 | code >> 12);
+        bytes += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+        bytes += static_cast<char>(0x80 | (code & 0x3f));
+    } else {
+        bytes += static_cast<char>(0xf0 | code >> 18);
+        bytes += static_cast<char>(0x80 | (code >> 12 & 0x3f));
+        bytes += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+        bytes += static_cast<char>(0x80 | (code & 0x3f));
+    }
+}
+
+/// length of the UTF-8 sequence `bytes` starts with if it is neither ASCII
+/// nor a C1 control character, else 0
+static auto printable_utf8(std::string_view bytes) -> size_t {
+    const auto lead = static_cast<unsigned char>(bytes[0]);
+    if (lead < 0x80 || (lead == 0xc2 && bytes.size() > 1 && static_cast<unsigned char>(bytes[1]) < 0xa0)) return 0;
+    return simd::utf8_length(bytes.data(), bytes.data() + bytes.size());
+}
+
+}  // namespace detail
+
+auto Literal::intern(std::string_view bytes) -> Literal {
+    if (bytes.empty()) return Literal();
+    return Literal(detail::LiteralPool::instance().intern(bytes));
+}
+
+auto Literal::string() const -> std::string_view {
+    if (m_id == 0) return {};
+    return detail::LiteralPool::instance().bytes(m_id);
+}
+
+extern auto decode_literal(std::string_view text, std::string &bytes) -> bool {
+    bytes.clear();
+    for (size_t i = 0; i < text.size();) {
+        const auto first = text.find('\\', i);
+        bytes.append(text, i, first - i);
+        if (first == std::string_view::npos) break;
+        if (first + 1 == text.size()) return false;
+
+        const auto ch = text[first + 1];
+        i             = first + 2;
+        switch (ch) {
+            case 'a': bytes += '\a'; break;
+            case 'b': bytes += '\b'; break;
+            case 'f': bytes += '\f'; break;
+            case 'n': bytes += '\n'; break;
+            case 'r': bytes += '\r'; break;
+            case 't': bytes += '\t'; break;
+            case 'v': bytes += '\v'; break;
+            case '\\':
+            case '\'':
+            case '\"':
+            case '?': bytes += ch; break;
+            case 'x': {
+                // as many hex digits as there are, the value has to fit a char
+                uint32_t value = 0;
+                size_t digits  = 0;
+                for (int digit; i < text.size() && (digit = detail::hex_value(text[i])) >= 0; ++i, ++digits) {
+                    value = value << 4 | digit;
+                    if (value > 0xff) return false;
+                }
+                if (digits == 0) return false;
+                bytes += static_cast<char>(value);
+                break;
+            }
+            case 'u':
+            case 'U': {
+                const size_t digits = ch == 'u' ? 4 : 8;
+                if (text.size() - i < digits) return false;
+                uint32_t value = 0;
+                for (size_t j = 0; j < digits; ++j) {
+                    const auto digit = detail::hex_value(text[i + j]);
+                    if (digit < 0) return false;
+                    value = value << 4 | digit;
+                }
+                if (value > 0x10ffff || (value >= 0xd800 && value <= 0xdfff)) return false;
+                detail::append_utf8(bytes, value);
+                i += digits;
+                break;
+            }
+            default: {
+                // up to three octal digits
+                if (ch < '0' || ch > '7') return false;
+                uint32_t value = ch - '0';
+                for (size_t j = 0; j < 2 && i < text.size() && text[i] >= '0' && text[i] <= '7'; ++j) value = value << 3 | (text[i++] - '0');
+                if (value > 0xff) return false;
+                bytes += static_cast<char>(value);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+extern auto escape_literal(std::string_view bytes, char quote) -> std::string {
+    static constexpr char kHex[] = "0123456789abcdef";
+
+    std::string result;
+    result.reserve(bytes.size());
+    bool after_hex = false;  // a hex digit now would extend the `\x` escape
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        const auto ch     = static_cast<unsigned char>(bytes[i]);
+        const auto escape = after_hex && detail::hex_value(static_cast<char>(ch)) >= 0;
+        after_hex         = false;
+        switch (ch) {
+            case '\a': result += "\\a"; break;
+            case '\b': result += "\\b"; break;
+            case '\f': result += "\\f"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            case '\v': result += "\\v"; break;
+            case '\\': result += "\\\\"; break;
+            default:
+                if (ch == static_cast<unsigned char>(quote)) {
+                    result += '\\';
+                    result += quote;
+                } else if (escape) {
+                    // all three octal digits, it ends after them
+                    result += '\\';
+                    result += static_cast<char>('0' + (ch >> 6));
+                    result += static_cast<char>('0' + (ch >> 3 & 7));
+                    result += static_cast<char>('0' + (ch & 7));
+                } else if (const auto length = detail::printable_utf8(bytes.substr(i))) {
+                    result.append(bytes, i, length);
+                    i += length - 1;
+                } else if (ch < 0x20 || ch >= 0x7f) {
+                    // control characters and bytes that are not UTF-8
+                    result += "\\x";
+                    result += kHex[ch >> 4];
+                    result += kHex[ch & 15];
+                    after_hex = true;
+                } else {
+                    result += static_cast<char>(ch);
+                }
+                break;
+        }
+    }
+    return result;
+}
+
+}  // namespace mcc
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace mcc {
+
+/// Literal
+/// ----------------------------------------------------------------------------
+/// Handle of the decoded bytes of a string or character literal, escapes
+/// resolved, in a process wide pool. Equal bytes are stored only once, so
+/// equal literals get equal ids. The bytes are kept in blocks that never move
+/// or get freed, like the spellings of symbols. The default literal is empty.
+class Literal {
+public:
+    constexpr Literal() : m_id(0) {}
+
+    /// thread safe, the parallel lexer interns from all of its threads
+    static auto intern(std::string_view bytes) -> Literal;
+
+    inline auto id() const -> uint32_t { return m_id; }
+    inline auto empty() const -> bool { return m_id == 0; }
+    /// valid for the whole process
+    auto string() const -> std::string_view;
+
+    inline auto operator==(Literal other) const -> bool { return m_id == other.m_id; }
+    inline auto operator!=(Literal other) const -> bool { return m_id != other.m_id; }
+
+private:
+    constexpr explicit Literal(uint32_t id) : m_id(id) {}
+
+    uint32_t m_id;
+};
+
+/// decodes the text between the quotes of a literal into `bytes`, false if
+/// it has an invalid escape sequence.
+extern auto decode_literal(std::string_view text, std::string &bytes) -> bool;
+
+/// spells `bytes` as the text between the quotes of a C literal quoted by
+/// `quote`, the inverse of `decode_literal()`.
+extern auto escape_literal(std::string_view bytes, char quote) -> std::string;
+
+}  // namespace mcc
@@ -10,7 +10,7 @@
 
 auto main(int argc, const char** argv) -> int {
     if (argc < 2) {
-        std::cout << "\nUsage: mcc <file>\n\n";
+        std::cout << "\nUsage: mcc <file>    (`-` reads the source from stdin)\n\n";
     } else {
         auto source_stream = mcc::SrcStream(argv[1]);
         auto token_stream  = mcc::lex(std::move(source_stream));
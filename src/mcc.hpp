@@ -1,12 +1,20 @@
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "astfwd.hpp"
+#include "lexcontext.hpp"
 #include "tkstream.hpp"
 #include "token.hpp"
 
 namespace mcc {
 
 extern auto lex(SrcStream &&ss) -> TkStream;
+extern auto lex(std::string_view source, std::string srcfile) -> TkStream;
+extern auto lex_parallel(FileID file, size_t threads = 0) -> TokenBuffer;
+extern auto lex_batch(LexContext &context, const std::vector<std::string_view> &snippets) -> void;
+extern auto relex(TokenBuffer &tokens, FileID file, const SrcEdit &edit) -> TokenDiff;
+extern auto lex_error_message(const Token &token) -> const char *;
 extern auto preprocess(TkStream &&ts) -> TkStream;
 extern auto parse(TkStream &&ts) -> AstProgram;
 
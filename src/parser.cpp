@@ -13,7 +13,7 @@ namespace mcc {
 ///                     | struct_spec | union_spec | enum_spec | id
 ///
 static auto parse_stmt(TkStream &ts) -> AstStmtPointer;
-static auto parse_declarator(TkStream &ts, QualType type) -> std::pair<QualType, std::string>;
+static auto parse_declarator(TkStream &ts, QualType type) -> std::pair<QualType, Symbol>;
 static auto parse_compound_stmt(TkStream &ts) -> std::unique_ptr<AstStmtCompound>;
 static auto parse_conditional_expr(TkStream &) -> AstExprPointer;
 static auto parse_type_cast_expr(TkStream &) -> AstExprPointer;
@@ -36,12 +36,12 @@ template <typename ToOptr, typename Descent>
 static auto recursive_descent(Descent descent) {
     return [descent](TkStream &ts) -> AstExprPointer {
         auto result = descent(ts);
-        auto optr   = ToOptr::to_optr(ts.peek().kind);
+        auto optr   = ToOptr::to_optr(ts.peek_kind());
 
         while (optr != OptrKind::None) {
             ts.next();
             result = std::make_unique<AstExprBinary>(optr, std::move(result), descent(ts));
-            optr   = ToOptr::to_optr(ts.peek().kind);
+            optr   = ToOptr::to_optr(ts.peek_kind());
         }
 
         return result;
@@ -70,15 +70,15 @@ static auto parse_qual_spec(TkStream &ts) -> std::pair<QualSpec, QualType> {
     auto decl_spec = QualSpec{Qualifier::None, Specifier::None};
 
     for (; ts; ts.next()) {
-        const auto token = ts.peek();
-        if (const auto specifier = token_to_specifier(token.kind); specifier != Specifier::None) {
+        const auto kind = ts.peek_kind();
+        if (const auto specifier = token_to_specifier(kind); specifier != Specifier::None) {
             if ((specifier & std::get<Specifier>(decl_spec)) != Specifier::None) {
-                panic("type specifier redefined.", token.loc);
+                panic("type specifier redefined.", ts.peek_loc());
             }
             std::get<Specifier>(decl_spec) |= specifier;
-        } else if (const auto qualifier = token_to_qualifier(token.kind); qualifier != Qualifier::None) {
+        } else if (const auto qualifier = token_to_qualifier(kind); qualifier != Qualifier::None) {
             if ((qualifier & std::get<Qualifier>(decl_spec)) != Qualifier::None) {
-                panic("type qualifier redefined.", token.loc);
+                panic("type qualifier redefined.", ts.peek_loc());
             }
             std::get<Qualifier>(decl_spec) |= qualifier;
         } else {
@@ -97,20 +97,20 @@ static auto parse_decl_spec(TkStream &ts) -> std::pair<DeclSpec, QualType> {
     auto decl_spec = DeclSpec{StorageClass::None, Qualifier::None, Specifier::None};
 
     for (; ts; ts.next()) {
-        const auto token = ts.peek();
-        if (const auto storage = token_to_storage_class(token.kind); storage != StorageClass::None) {
+        const auto kind = ts.peek_kind();
+        if (const auto storage = token_to_storage_class(kind); storage != StorageClass::None) {
             if (std::get<StorageClass>(decl_spec) != StorageClass::None) {
-                panic("storage class specifier redefined.", token.loc);
+                panic("storage class specifier redefined.", ts.peek_loc());
             }
             std::get<StorageClass>(decl_spec) = storage;
-        } else if (const auto specifier = token_to_specifier(token.kind); specifier != Specifier::None) {
+        } else if (const auto specifier = token_to_specifier(kind); specifier != Specifier::None) {
             if ((specifier & std::get<Specifier>(decl_spec)) != Specifier::None) {
-                panic("type specifier redefined.", token.loc);
+                panic("type specifier redefined.", ts.peek_loc());
             }
             std::get<Specifier>(decl_spec) |= specifier;
-        } else if (const auto qualifier = token_to_qualifier(token.kind); qualifier != Qualifier::None) {
+        } else if (const auto qualifier = token_to_qualifier(kind); qualifier != Qualifier::None) {
             if ((qualifier & std::get<Qualifier>(decl_spec)) != Qualifier::None) {
-                panic("type qualifier redefined.", token.loc);
+                panic("type qualifier redefined.", ts.peek_loc());
             }
             std::get<Qualifier>(decl_spec) |= qualifier;
         } else {
@@ -122,7 +122,7 @@ static auto parse_decl_spec(TkStream &ts) -> std::pair<DeclSpec, QualType> {
     auto qual_type = QualType(std::move(base_type), std::get<Qualifier>(decl_spec));
     return {decl_spec, qual_type};
 }
-static auto parse_param_decl(TkStream &ts) -> std::pair<QualType, std::string> {
+static auto parse_param_decl(TkStream &ts) -> std::pair<QualType, Symbol> {
     ///
     /// param_decl          : qual_spec declarator
     ///                     | qual_spec abstract_declarator
@@ -181,7 +181,7 @@ static auto parse_func_declarator(TkStream &ts, const QualType &type) -> QualTyp
     ts.expect(TokenKind::RParen, "expect function param list terminator `)`.");
     return QualType(func);
 }
-static auto parse_declarator(TkStream &ts, QualType type) -> std::pair<QualType, std::string> {
+static auto parse_declarator(TkStream &ts, QualType type) -> std::pair<QualType, Symbol> {
     ///
     /// declarator          : [pointer] direct_declarator
     /// pointer             : '*' {type_qual}+ [pointer]
@@ -189,18 +189,18 @@ static auto parse_declarator(TkStream &ts, QualType type) -> std::pair<QualType,
     /// func_declarator     : '(' {param_decl ','}['...'] ')';
     /// array_declarator    : {'[' [const_exp] ']'}
     ///
-    auto ident = std::string(IAstDecl::kAnonymous);
+    auto ident = IAstDecl::kAnonymous;
 
     while (ts.match(TokenKind::Mul /* * */)) {
         auto qual  = Qualifier::None;
-        auto value = token_to_qualifier(ts.peek().kind);
+        auto value = token_to_qualifier(ts.peek_kind());
         while (value != Qualifier::None) {
             if ((value & qual) != Qualifier::None) {
-                panic("type qualifier redefined.", ts.peek().loc);
+                panic("type qualifier redefined.", ts.peek_loc());
             }
             qual |= value;
             ts.next();
-            value = token_to_qualifier(ts.peek().kind);
+            value = token_to_qualifier(ts.peek_kind());
         }
         type = QualType(std::make_unique<PointerType>(std::move(type)), qual);
     }
@@ -241,7 +241,7 @@ static auto parse_decl(TkStream &ts) -> AstDeclPointer {
         } else if (ts.detect(TokenKind::LBrace /* } */)) {
             return std::make_unique<AstDeclFunc>(storage, type, parse_compound_stmt(ts), identifier);
         }
-        panic("expect `;` or `{` in function declaration.", ts.peek().loc);
+        panic("expect `;` or `{` in function declaration.", ts.peek_loc());
     } else {
         if (ts.match(TokenKind::Semicolon /* ; */)) {
             return std::make_unique<AstDeclVar>(storage, type, nullptr, identifier);
@@ -250,14 +250,14 @@ static auto parse_decl(TkStream &ts) -> AstDeclPointer {
             ts.expect(TokenKind::Semicolon, "expect `;` after initializer list.");
             return std::make_unique<AstDeclVar>(storage, type, std::move(initial), identifier);
         }
-        panic("expect `;` or `=` in variable declaration.", ts.peek().loc);
+        panic("expect `;` or `=` in variable declaration.", ts.peek_loc());
     }
 }
 static auto parse_compound_stmt(TkStream &ts) -> std::unique_ptr<AstStmtCompound> {
     std::vector<AstPointer> stmts;
     ts.expect(TokenKind::LBrace, "expect `{`.");
     while (!ts.match(TokenKind::RBrace)) {
-        auto kind = ts.peek().kind;
+        auto kind = ts.peek_kind();
 
         if (token_to_qualifier(kind) != Qualifier::None ||
             token_to_specifier(kind) != Specifier::None ||
@@ -312,7 +312,7 @@ static auto parse_stmt(TkStream &ts) -> AstStmtPointer {
         ts.expect(TokenKind::Semicolon, "expect `;` after `while`.");
         return std::make_unique<AstStmtIterationDoWhile>(std::move(cond), std::move(body));
     } else if (ts.match(TokenKind::KwGoto)) {
-        auto lable = ts.peek().string;
+        auto lable = ts.peek_symbol();
         ts.expect(TokenKind::Ident, "expect goto lable.");
         ts.expect(TokenKind::Semicolon, "expect `;` after `goto`.");
         return std::make_unique<AstStmtJumpGoto>(lable);
@@ -334,11 +334,13 @@ static auto parse_stmt(TkStream &ts) -> AstStmtPointer {
         ts.expect(TokenKind::Colon, "expect `:` after `case`.");
         return std::make_unique<AstStmtLableCase>(std::move(expr));
     } else {
-        auto loc   = ts.location();
-        auto token = ts.next();
+        auto loc    = ts.location();
+        auto kind   = ts.peek_kind();
+        auto symbol = ts.peek_symbol();
+        ts.next();
 
-        if (token.kind == TokenKind::Ident && ts.match(TokenKind::Colon)) {
-            return std::make_unique<AstStmtLable>(token.string);
+        if (kind == TokenKind::Ident && ts.match(TokenKind::Colon)) {
+            return std::make_unique<AstStmtLable>(symbol);
         } else {
             ts.reset(loc);
             auto expr = parse_expr(ts);
@@ -357,24 +359,37 @@ static auto parse_conditional_expr(TkStream &ts) -> AstExprPointer {
     }
     return result;
 }
+/// adjacent string literals are concatenated into one
+static auto parse_string(TkStream &ts) -> Literal {
+    auto literal = ts.peek_literal();
+    ts.next();
+    if (!ts.detect(TokenKind::Str)) return literal;
+
+    std::string bytes(literal.string());
+    for (; ts.detect(TokenKind::Str); ts.next()) bytes += ts.peek_literal().string();
+    return Literal::intern(bytes);
+}
 static auto parse_primary_expr(TkStream &ts) -> AstExprPointer {
-    std::string string;
+    Literal literal;
+    Symbol symbol;
 
     if (ts.match(TokenKind::LParen)) {
         auto result = parse_expr(ts);
         ts.expect(TokenKind::RParen, "expect `)`.");
         return result;
-    } else if (ts.match(TokenKind::Ident, string)) {
-        return std::make_unique<AstExprIdentifier>(string);
-    } else if (ts.match(TokenKind::Str, string)) {
-        return std::make_unique<AstExprString>(string);
-    } else if (ts.match(TokenKind::Char, string)) {
-        return std::make_unique<AstExprCharacter>(string);
-    } else if (ts.match(TokenKind::Const, string)) {
-        return std::make_unique<AstExprConstant>(string);
+    } else if (ts.match(TokenKind::Ident, symbol)) {
+        return std::make_unique<AstExprIdentifier>(symbol);
+    } else if (ts.detect(TokenKind::Str)) {
+        return std::make_unique<AstExprString>(parse_string(ts));
+    } else if (ts.match(TokenKind::Char, literal)) {
+        return std::make_unique<AstExprCharacter>(literal);
+    } else if (ts.detect(TokenKind::Const)) {
+        const auto constant = ts.peek_constant();
+        const auto token    = ts.take();
+        return std::make_unique<AstExprConstant>(constant, token.loc, token.length);
     }
 
-    panic("invalid expression.", ts.peek().loc);
+    panic("invalid expression.", ts.peek_loc());
 }
 static auto parse_postfix_expr(TkStream &ts) -> AstExprPointer {
     auto result = parse_primary_expr(ts);
@@ -407,10 +422,10 @@ static auto parse_postfix_expr(TkStream &ts) -> AstExprPointer {
 static auto parse_unary_expr(TkStream &ts) -> AstExprPointer {
     /// TODO: parse sizeof operator
 
-    if (auto optr = token_to_unary_optr_t::to_optr(ts.peek().kind); optr != OptrKind::None) {
+    if (auto optr = token_to_unary_optr_t::to_optr(ts.peek_kind()); optr != OptrKind::None) {
         ts.next();
         return std::make_unique<AstExprUnary>(optr, parse_unary_expr(ts));
-    } else if (auto optr = token_to_inc_dec_optr_t::to_optr(ts.peek().kind); optr != OptrKind::None) {
+    } else if (auto optr = token_to_inc_dec_optr_t::to_optr(ts.peek_kind()); optr != OptrKind::None) {
         ts.next();
         return std::make_unique<AstExprUnary>(optr, parse_type_cast_expr(ts));
     }
@@ -422,7 +437,7 @@ static auto parse_type_cast_expr(TkStream &ts) -> AstExprPointer {
     return parse_unary_expr(ts);
 }
 extern auto parse(TkStream &&_ts) -> AstProgram {
-    TkStream ts = _ts;
+    auto ts = std::move(_ts);
     std::vector<AstDeclPointer> decls;
     while (ts) decls.emplace_back(parse_decl(ts));
     return AstProgram(std::move(decls));
@@ -1,4 +1,4 @@
-#include <map>
+#include <unordered_map>
 
 #include "error.hpp"
 #include "mcc.hpp"
@@ -6,73 +6,147 @@
 
 namespace mcc {
 
-static auto try_preprocessor(TkStream &ts, std::map<std::string, std::vector<Token>> &macros, std::vector<Token> &result) -> bool {
-    while (ts.match(TokenKind::Line)) {
-        if (ts.match(TokenKind::Sharp)) {
-            auto pp  = ts.peek().string;
-            auto loc = ts.peek().loc;
-            ts.expect(TokenKind::Ident, "expect identifier after `#`.");
-            if (pp == "define") {
-                ///
-                /// #define MACRO {TOKENS}
-                ///
-                auto macro   = ts.peek().string;
-                auto &tokens = macros[macro];
-                ts.expect(TokenKind::Ident, "expect macro name in `#define`.");
-                while (ts && !ts.detect(TokenKind::Line)) {
-                    tokens.push_back(ts.next());
-                }
-            } else if (pp == "undef") {
-                ///
-                /// #undef MACRO
-                ///
-                auto macro = ts.peek().string;
-                ts.expect(TokenKind::Ident, "expect macro name in `#undef`.");
-                macros.erase(macro);
-            } else if (pp == "include") {
-                ///
-                /// #include "path/to/header"
-                ///
-                auto path = std::string(ts.peek().string);
-                ts.expect(TokenKind::Str, "expect path in `#include`.");
-
-                TkStream inc = preprocess(lex(SrcStream(path.c_str())));
-                result.insert(result.end(), inc.begin(), inc.end());
-            } else {
-                panic("invalid preprocessor", loc);
+/// lexes an included file only once per process. `SourceManager::load()`
+/// already returns the same file id while the canonical path, inode and
+/// mtime are unchanged, so the lexed tokens are cached by that id.
+static auto lex_include(const std::string &path) -> TkStream {
+    static std::unordered_map<FileID, TokenBuffer> cache;
+
+    const auto file = SourceManager::instance().load(path.c_str());
+    auto iter       = cache.find(file);
+    if (iter == cache.end()) iter = cache.emplace(file, lex(SrcStream(file)).collect()).first;
+    return TkStream(TokenBuffer(iter->second));
+}
+
+/// Preprocessor
+/// ----------------------------------------------------------------------------
+/// Runs the directives and expands macros as the parser pulls tokens. Every
+/// `#include` pushes a frame with its own macros, which is popped when the
+/// included tokens run out.
+class Preprocessor : public TokenSource {
+public:
+    Preprocessor(TkStream &&ts);
+
+    auto next() -> Token override;
+    auto value() const -> TokenValue override { return m_value; }
+
+private:
+    using Macros = std::unordered_map<Symbol, TokenBuffer>;
+
+    struct Frame {
+        TkStream ts;
+        Macros macros;
+    };
+
+    auto try_preprocessor(Frame &frame) -> bool;
+    auto try_expand_macro(Frame &frame) -> bool;
+
+    std::vector<Frame> m_frames;
+    const TokenBuffer *m_expansion;  // body of the macro being expanded, map nodes do not move
+    size_t m_expanded;               // tokens of `m_expansion` handed out
+    size_t m_expanded_constants;     // and the constants among them
+    size_t m_expanded_symbols;       // and the identifiers
+    size_t m_expanded_literals;      // and the literals
+    TokenValue m_value;
+};
+
+Preprocessor::Preprocessor(TkStream &&ts)
+    : m_expansion(nullptr), m_expanded(0), m_expanded_constants(0), m_expanded_symbols(0), m_expanded_literals(0) {
+    m_frames.push_back({std::move(ts), {}});
+
+    // has the source manager read all of the headers in one batch, before
+    // `lex_include()` asks for them one by one. An empty source has no
+    // file to look at, its `Eof` is at no place.
+    auto &first = m_frames.back().ts;
+    if (first) SourceManager::instance().prefetch(first.peek_loc().file);
+}
+
+auto Preprocessor::next() -> Token {
+    for (;;) {
+        if (m_expansion) {
+            if (m_expanded < m_expansion->size()) {
+                const auto kind = m_expansion->kind(m_expanded);
+                if (kind == TokenKind::Const) m_value.constant = m_expansion->constants()[m_expanded_constants++];
+                if (kind == TokenKind::Ident) m_value.symbol = m_expansion->symbols()[m_expanded_symbols++];
+                if (is_literal(kind)) m_value.literal = m_expansion->literals()[m_expanded_literals++];
+                return (*m_expansion)[m_expanded++];
             }
-            return true;
+            m_expansion = nullptr;
+        }
+
+        auto &frame = m_frames.back();
+        if (try_preprocessor(frame)) continue;
+        if (try_expand_macro(frame)) continue;
+        if (frame.ts) {
+            if (has_value(frame.ts.peek_kind())) m_value = frame.ts.peek_value();
+            return frame.ts.take();
         }
+        if (m_frames.size() == 1) return frame.ts.peek();
+        m_frames.pop_back();
     }
-    return false;
 }
-static auto try_expand_macro(TkStream &ts, std::map<std::string, std::vector<Token>> &macros, std::vector<Token> &result) -> bool {
+
+auto Preprocessor::try_preprocessor(Frame &frame) -> bool {
+    auto &ts = frame.ts;
+    if (!ts.peek_line_start() || !ts.match(TokenKind::Sharp)) return false;
+
+    static const auto kDefine  = Symbol::intern("define");
+    static const auto kUndef   = Symbol::intern("undef");
+    static const auto kInclude = Symbol::intern("include");
+
+    auto pp  = ts.peek_symbol();
+    auto loc = ts.peek_loc();
+    ts.expect(TokenKind::Ident, "expect identifier after `#`.");
+    if (pp == kDefine) {
+        ///
+        /// #define MACRO {TOKENS}
+        ///
+        auto &tokens = frame.macros[ts.peek_symbol()];
+        ts.expect(TokenKind::Ident, "expect macro name in `#define`.");
+        while (ts && !ts.peek_line_start()) {
+            ts.take(tokens);
+        }
+    } else if (pp == kUndef) {
+        ///
+        /// #undef MACRO
+        ///
+        auto macro = ts.peek_symbol();
+        ts.expect(TokenKind::Ident, "expect macro name in `#undef`.");
+        frame.macros.erase(macro);
+    } else if (pp == kInclude) {
+        ///
+        /// #include "path/to/header"
+        ///
+        auto path = std::string(ts.peek_literal().string());
+        ts.expect(TokenKind::Str, "expect path in `#include`.");
+
+        // `frame` dangles from here on
+        m_frames.push_back({lex_include(path), {}});
+    } else {
+        panic("invalid preprocessor", loc);
+    }
+    return true;
+}
+
+auto Preprocessor::try_expand_macro(Frame &frame) -> bool {
+    auto &ts = frame.ts;
     if (ts.detect(TokenKind::Ident)) {
-        auto macro = ts.peek().string;
-        auto iter  = macros.find(macro);
-        if (iter != macros.end()) {
+        auto iter = frame.macros.find(ts.peek_symbol());
+        if (iter != frame.macros.end()) {
             ts.next();
-            result.insert(result.end(), iter->second.begin(), iter->second.end());
+            m_expansion          = &iter->second;
+            m_expanded           = 0;
+            m_expanded_constants = 0;
+            m_expanded_symbols   = 0;
+            m_expanded_literals  = 0;
             return true;
         }
     }
     return false;
 }
 
-extern auto preprocess(TkStream &&_ts) -> TkStream {
-    std::map<std::string, std::vector<Token>> macros;
-    std::vector<Token> result;
-    auto ts = _ts;
-
-    result.reserve(ts.end() - ts.begin());
-
-    while (ts) {
-        if (try_preprocessor(ts, macros, result)) continue;
-        if (try_expand_macro(ts, macros, result)) continue;
-        if (ts) result.push_back(ts.next());
-    }
-
-    return TkStream(std::move(result));
+extern auto preprocess(TkStream &&ts) -> TkStream {
+    return TkStream(std::make_unique<Preprocessor>(std::move(ts)));
 }
 
 }  // namespace mcc
\ No newline at end of file
@@ -1,10 +1,10 @@
 #pragma once
 
-#include <map>
 #include <memory>
-#include <string_view>
+#include <unordered_map>
 
 #include "astfwd.hpp"
+#include "symbol.hpp"
 
 namespace mcc {
 
@@ -29,7 +29,7 @@ public:
 private:
     ScopeKind m_kind;
     Scope *m_parent;
-    std::map<std::string_view, IAst *> m_idents;
+    std::unordered_map<Symbol, IAst *> m_idents;
 };
 
 }  // namespace mcc
\ No newline at end of file
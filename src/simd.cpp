@@ -0,0 +1,315 @@
+#include "simd.hpp"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MCC_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define MCC_SIMD_X86 0
+#endif
+
+namespace mcc {
+
+namespace simd {
+
+namespace detail {
+
+static auto scan_lines_scalar(const char *data, size_t size, uint32_t base, std::vector<uint32_t> &result) -> void {
+    for (auto p = data, last = data + size; (p = static_cast<const char *>(std::memchr(p, '\n', last - p))); ++p) {
+        result.push_back(base + static_cast<uint32_t>(p - data) + 1);
+    }
+}
+
+#if MCC_SIMD_X86
+/// pushes the line start following every bit set in `mask`.
+static inline auto push_lines(uint32_t mask, uint32_t offset, std::vector<uint32_t> &result) -> void {
+    for (; mask; mask &= mask - 1) result.push_back(offset + __builtin_ctz(mask) + 1);
+}
+
+__attribute__((target("sse2"))) static auto scan_lines_sse2(const char *data, size_t size, uint32_t base, std::vector<uint32_t> &result) -> void {
+    const auto newline = _mm_set1_epi8('\n');
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        push_lines(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)), base + i, result);
+    }
+    scan_lines_scalar(data + i, size - i, base + i, result);
+}
+
+__attribute__((target("avx2"))) static auto scan_lines_avx2(const char *data, size_t size, uint32_t base, std::vector<uint32_t> &result) -> void {
+    const auto newline = _mm256_set1_epi8('\n');
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        push_lines(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)), base + i, result);
+    }
+    scan_lines_sse2(data + i, size - i, base + i, result);
+}
+#endif
+
+/// character classes shared by the scalar and vector scanners
+/// ----------------------------------------------------------------------------
+struct Blank {
+    static constexpr auto test(unsigned char ch) -> bool { return ch == ' ' || ch == '\t'; }
+};
+struct Ident {
+    static constexpr auto test(unsigned char ch) -> bool {
+        return static_cast<unsigned char>((ch | 0x20) - 'a') < 26 ||
+               static_cast<unsigned char>(ch - '0') < 10 || ch == '_' || ch == '$';
+    }
+};
+struct Number {
+    static constexpr auto test(unsigned char ch) -> bool { return Ident::test(ch) || ch == '.'; }
+};
+struct Ascii {
+    static constexpr auto test(unsigned char ch) -> bool { return ch < 0x80; }
+};
+struct Line {
+    static constexpr auto test(unsigned char ch) -> bool { return ch != '\n' && ch != '\0'; }
+};
+struct Comment {
+    static constexpr auto test(unsigned char ch) -> bool { return ch != '*' && ch != '\0'; }
+};
+
+template <typename Class>
+static auto skip_scalar(const char *first, const char *last) -> const char * {
+    while (first != last && Class::test(*first)) ++first;
+    return first;
+}
+
+#if MCC_SIMD_X86
+/// `x` in [lo, hi], bytes >= 0x80 compare negative and never match.
+__attribute__((target("sse2"))) static inline auto in_range(__m128i x, char lo, char hi) -> __m128i {
+    return _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(x, _mm_set1_epi8(hi + 1)));
+}
+__attribute__((target("avx2"))) static inline auto in_range(__m256i x, char lo, char hi) -> __m256i {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), x));
+}
+
+__attribute__((target("sse2"))) static inline auto match(Blank, __m128i x) -> __m128i {
+    return _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\t')));
+}
+__attribute__((target("sse2"))) static inline auto match(Ident, __m128i x) -> __m128i {
+    const auto alpha = in_range(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+    const auto digit = in_range(x, '0', '9');
+    const auto other = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('_')), _mm_cmpeq_epi8(x, _mm_set1_epi8('$')));
+    return _mm_or_si128(_mm_or_si128(alpha, digit), other);
+}
+__attribute__((target("sse2"))) static inline auto match(Number, __m128i x) -> __m128i {
+    return _mm_or_si128(match(Ident{}, x), _mm_cmpeq_epi8(x, _mm_set1_epi8('.')));
+}
+
+__attribute__((target("sse2"))) static inline auto match(Ascii, __m128i x) -> __m128i {
+    return _mm_cmpgt_epi8(x, _mm_set1_epi8(-1));
+}
+
+/// anything but `stop` and '\0'
+__attribute__((target("sse2"))) static inline auto match_until(__m128i x, char stop) -> __m128i {
+    const auto hit = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(stop)), _mm_cmpeq_epi8(x, _mm_setzero_si128()));
+    return _mm_xor_si128(hit, _mm_set1_epi8(-1));
+}
+__attribute__((target("sse2"))) static inline auto match(Line, __m128i x) -> __m128i { return match_until(x, '\n'); }
+__attribute__((target("sse2"))) static inline auto match(Comment, __m128i x) -> __m128i { return match_until(x, '*'); }
+
+__attribute__((target("avx2"))) static inline auto match(Blank, __m256i x) -> __m256i {
+    return _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t')));
+}
+__attribute__((target("avx2"))) static inline auto match(Ident, __m256i x) -> __m256i {
+    const auto alpha = in_range(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z');
+    const auto digit = in_range(x, '0', '9');
+    const auto other = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('$')));
+    return _mm256_or_si256(_mm256_or_si256(alpha, digit), other);
+}
+__attribute__((target("avx2"))) static inline auto match(Number, __m256i x) -> __m256i {
+    return _mm256_or_si256(match(Ident{}, x), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('.')));
+}
+
+__attribute__((target("avx2"))) static inline auto match(Ascii, __m256i x) -> __m256i {
+    return _mm256_cmpgt_epi8(x, _mm256_set1_epi8(-1));
+}
+
+__attribute__((target("avx2"))) static inline auto match_until(__m256i x, char stop) -> __m256i {
+    const auto hit = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(stop)), _mm256_cmpeq_epi8(x, _mm256_setzero_si256()));
+    return _mm256_xor_si256(hit, _mm256_set1_epi8(-1));
+}
+__attribute__((target("avx2"))) static inline auto match(Line, __m256i x) -> __m256i { return match_until(x, '\n'); }
+__attribute__((target("avx2"))) static inline auto match(Comment, __m256i x) -> __m256i { return match_until(x, '*'); }
+
+template <typename Class>
+__attribute__((target("sse2"))) static auto skip_sse2(const char *first, const char *last) -> const char * {
+    for (; last - first >= 16; first += 16) {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        const auto miss  = ~static_cast<uint32_t>(_mm_movemask_epi8(match(Class{}, chunk))) & 0xffff;
+        if (miss) return first + __builtin_ctz(miss);
+    }
+    return skip_scalar<Class>(first, last);
+}
+
+template <typename Class>
+__attribute__((target("avx2"))) static auto skip_avx2(const char *first, const char *last) -> const char * {
+    for (; last - first >= 32; first += 32) {
+        const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+        const auto miss  = ~static_cast<uint32_t>(_mm256_movemask_epi8(match(Class{}, chunk)));
+        if (miss) return first + __builtin_ctz(miss);
+    }
+    return skip_sse2<Class>(first, last);
+}
+
+/// pure ASCII text is the common case, so test a whole cache line per step
+/// and only look for the exact byte in the line that has one >= 0x80.
+__attribute__((target("sse2"))) static auto skip_ascii_sse2(const char *first, const char *last) -> const char * {
+    for (; last - first >= 64; first += 64) {
+        const auto c0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        const auto c1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first + 16));
+        const auto c2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first + 32));
+        const auto c3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first + 48));
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(c0, c1), _mm_or_si128(c2, c3)))) break;
+    }
+    return skip_sse2<Ascii>(first, last);
+}
+
+__attribute__((target("avx2"))) static auto skip_ascii_avx2(const char *first, const char *last) -> const char * {
+    for (; last - first >= 64; first += 64) {
+        const auto c0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+        const auto c1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first + 32));
+        if (_mm256_movemask_epi8(_mm256_or_si256(c0, c1))) break;
+    }
+    return skip_avx2<Ascii>(first, last);
+}
+#endif
+
+/// length of the well-formed UTF-8 sequence at `first`, 0 if there is none.
+/// Rejects overlong forms, surrogates and code points above U+10FFFF.
+static auto decode_utf8(const unsigned char *first, const unsigned char *last) -> size_t {
+    const auto lead = first[0];
+
+    size_t length    = 0;
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xbf;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        length = 2;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        length = 3;
+        if (lead == 0xe0) lo = 0xa0;
+        if (lead == 0xed) hi = 0x9f;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+        if (lead == 0xf0) lo = 0x90;
+        if (lead == 0xf4) hi = 0x8f;
+    } else {
+        return 0;
+    }
+
+    if (size_t(last - first) < length) return 0;
+    if (first[1] < lo || first[1] > hi) return 0;
+    for (size_t i = 2; i < length; ++i) {
+        if ((first[i] & 0xc0) != 0x80) return 0;
+    }
+    return length;
+}
+
+using ScanLines = auto (*)(const char *, size_t, uint32_t, std::vector<uint32_t> &) -> void;
+using Skip      = auto (*)(const char *, const char *) -> const char *;
+
+static auto has_avx2() -> bool {
+#if MCC_SIMD_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+static auto has_sse2() -> bool {
+#if MCC_SIMD_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#else
+    return false;
+#endif
+}
+
+static auto select_scan_lines() -> ScanLines {
+#if MCC_SIMD_X86
+    if (has_avx2()) return scan_lines_avx2;
+    if (has_sse2()) return scan_lines_sse2;
+#endif
+    return scan_lines_scalar;
+}
+
+static auto select_skip_ascii() -> Skip {
+#if MCC_SIMD_X86
+    if (has_avx2()) return skip_ascii_avx2;
+    if (has_sse2()) return skip_ascii_sse2;
+#endif
+    return skip_scalar<Ascii>;
+}
+
+template <typename Class>
+static auto select_skip() -> Skip {
+#if MCC_SIMD_X86
+    if (has_avx2()) return skip_avx2<Class>;
+    if (has_sse2()) return skip_sse2<Class>;
+#endif
+    return skip_scalar<Class>;
+}
+
+}  // namespace detail
+
+extern auto scan_lines(const char *data, size_t size, uint32_t base, std::vector<uint32_t> &result) -> void {
+    static const auto impl = detail::select_scan_lines();
+    impl(data, size, base, result);
+}
+
+extern auto skip_blank(const char *first, const char *last) -> const char * {
+    static const auto impl = detail::select_skip<detail::Blank>();
+    return impl(first, last);
+}
+
+extern auto skip_ident(const char *first, const char *last) -> const char * {
+    static const auto impl = detail::select_skip<detail::Ident>();
+    return impl(first, last);
+}
+
+extern auto skip_number(const char *first, const char *last) -> const char * {
+    static const auto impl = detail::select_skip<detail::Number>();
+    return impl(first, last);
+}
+
+extern auto skip_line(const char *first, const char *last) -> const char * {
+    static const auto impl = detail::select_skip<detail::Line>();
+    return impl(first, last);
+}
+
+extern auto skip_comment(const char *first, const char *last) -> const char * {
+    static const auto impl = detail::select_skip<detail::Comment>();
+    return impl(first, last);
+}
+
+extern auto validate_utf8(const char *data, size_t size, bool &ascii) -> size_t {
+    static const auto skip_ascii = detail::select_skip_ascii();
+
+    const auto last = data + size;
+    ascii           = true;
+    for (auto p = skip_ascii(data, last); p != last; p = skip_ascii(p, last)) {
+        ascii = false;
+        do {
+            const auto length = detail::decode_utf8(reinterpret_cast<const unsigned char *>(p), reinterpret_cast<const unsigned char *>(last));
+            if (length == 0) return p - data;
+            p += length;
+        } while (p != last && static_cast<unsigned char>(*p) >= 0x80);
+    }
+    return size;
+}
+
+extern auto utf8_length(const char *first, const char *last) -> size_t {
+    if (first == last) return 0;
+    return detail::decode_utf8(reinterpret_cast<const unsigned char *>(first), reinterpret_cast<const unsigned char *>(last));
+}
+
+}  // namespace simd
+
+}  // namespace mcc
\ No newline at end of file
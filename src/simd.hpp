@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mcc {
+
+namespace simd {
+
+/// Appends `base + i + 1` to `result` for every '\n' at `data[i]`, i.e. the
+/// offset of each line start after the first one. Uses AVX2 or SSE2 when the
+/// CPU has them and a scalar loop otherwise.
+extern auto scan_lines(const char *data, size_t size, uint32_t base, std::vector<uint32_t> &result) -> void;
+
+/// Return the first character in [first, last) that is not in the class, or
+/// `last`. They look at 32 or 16 bytes per step depending on the CPU.
+///
+///     skip_blank   : ' ' '\t'
+///     skip_ident   : [A-Za-z0-9_$]
+///     skip_number  : [A-Za-z0-9_$.]
+///     skip_line    : anything but '\n' '\0', the body of a `//` comment
+///     skip_comment : anything but '*' '\0', the body of a block comment
+///
+extern auto skip_blank(const char *first, const char *last) -> const char *;
+extern auto skip_ident(const char *first, const char *last) -> const char *;
+extern auto skip_number(const char *first, const char *last) -> const char *;
+extern auto skip_line(const char *first, const char *last) -> const char *;
+extern auto skip_comment(const char *first, const char *last) -> const char *;
+
+/// Checks that [data, data + size) is well-formed UTF-8 and returns the
+/// offset of the first ill-formed byte, or `size`. `ascii` tells whether
+/// every byte was below 0x80. Runs of ASCII are skipped 64 bytes per step.
+extern auto validate_utf8(const char *data, size_t size, bool &ascii) -> size_t;
+
+/// length of the well-formed UTF-8 sequence at `first`, 0 if there is none
+extern auto utf8_length(const char *first, const char *last) -> size_t;
+
+}  // namespace simd
+
+}  // namespace mcc
\ No newline at end of file
@@ -0,0 +1,642 @@
+#include "srcmanager.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "error.hpp"
+#include "fileio.hpp"
+#include "simd.hpp"
+
+#if __has_include(<sys/mman.h>)
+#define MCC_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#else
+#define MCC_HAS_MMAP 0
+#include <fstream>
+#include <sstream>
+#endif
+
+namespace mcc {
+
+namespace detail {
+
+#if MCC_HAS_MMAP
+static auto page_size() -> size_t {
+    static const auto size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+/// maps `size` bytes of `fd` read-only in front of zero-filled pages, so
+/// `data[size]` is a valid sentinel even if `size` is page aligned.
+static auto map(int fd, size_t size, size_t &mapped) -> const char * {
+    mapped    = (size + page_size()) & ~(page_size() - 1);
+    auto base = ::mmap(nullptr, mapped, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return nullptr;
+
+    if (::mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        ::munmap(base, mapped);
+        return nullptr;
+    }
+
+    ::madvise(base, size, MADV_SEQUENTIAL);
+    return static_cast<const char *>(base);
+}
+
+/// reads everything left in `fd`, used for pipes, ttys and other files that
+/// can not be mapped.
+static auto read(int fd, std::string &result) -> bool {
+    char chunk[64 * 1024];
+    for (;;) {
+        auto count = ::read(fd, chunk, sizeof(chunk));
+        if (count == 0) return true;
+        if (count < 0 && errno != EINTR) return false;
+        if (count > 0) result.append(chunk, count);
+    }
+}
+#endif
+
+/// appends the path of every `#include "path"` line in [first, last). Only a
+/// guess for prefetching, it does not know about comments.
+static auto scan_includes(const char *first, const char *last, std::vector<std::string> &result) -> void {
+    constexpr std::string_view kInclude = "include";
+
+    for (auto p = first; p < last;) {
+        auto eol = static_cast<const char *>(std::memchr(p, '\n', last - p));
+        if (eol == nullptr) eol = last;
+
+        auto q = simd::skip_blank(p, eol);
+        if (q < eol && *q == '#') {
+            q = simd::skip_blank(q + 1, eol);
+            if (std::string_view(q, eol - q).substr(0, kInclude.size()) == kInclude) {
+                q = simd::skip_blank(q + kInclude.size(), eol);
+                if (q < eol && *q == '"') {
+                    auto close = static_cast<const char *>(std::memchr(q + 1, '"', eol - q - 1));
+                    if (close != nullptr) result.emplace_back(q + 1, close);
+                }
+            }
+        }
+        p = eol + 1;
+    }
+}
+
+}  // namespace detail
+
+SrcBuffer::SrcBuffer(const char *srcfile)
+    : m_data(nullptr), m_size(0), m_skip(0), m_mapped(0) {
+#if MCC_HAS_MMAP
+    int fd = ::open(srcfile, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) panic(std::string("failed to open file ") + srcfile);
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        m_size = static_cast<size_t>(st.st_size);
+        m_data = detail::map(fd, m_size, m_mapped);
+    }
+
+    if (m_data == nullptr) {
+        m_mapped = 0;
+        if (!detail::read(fd, m_storage)) panic(std::string("failed to read file ") + srcfile);
+        m_data = m_storage.c_str();
+        m_size = m_storage.size();
+    }
+
+    ::close(fd);
+#else
+    std::ifstream file(srcfile, std::ios::binary);
+    if (!file) panic(std::string("failed to open file ") + srcfile);
+
+    std::ostringstream os;
+    os << file.rdbuf();
+    m_storage = os.str();
+    m_data    = m_storage.c_str();
+    m_size    = m_storage.size();
+#endif
+    skip_bom();
+}
+
+/// takes over bytes read elsewhere, e.g. by `SourceManager::prefetch()`
+SrcBuffer::SrcBuffer(std::string contents)
+    : m_data(nullptr), m_size(contents.size()), m_skip(0), m_mapped(0), m_storage(std::move(contents)) {
+    m_data = m_storage.c_str();
+    skip_bom();
+}
+
+/// copies `source`, nothing past the view is read
+SrcBuffer::SrcBuffer(std::string_view source)
+    : m_data(nullptr), m_size(0), m_skip(0), m_mapped(0) {
+    assign(source);
+}
+
+/// borrows the `size` bytes at `data`, `data[size]` has to be a '\0' too
+SrcBuffer::SrcBuffer(const char *data, size_t size)
+    : m_data(nullptr), m_size(0), m_skip(0), m_mapped(0) {
+    borrow(data, size);
+}
+
+/// points the buffer at a copy of `source`, unmapping what it mapped
+auto SrcBuffer::rebind(std::string_view source) -> void {
+    unmap();
+    assign(source);
+}
+
+/// points the buffer at the bytes at `data`, see the constructor
+auto SrcBuffer::rebind(const char *data, size_t size) -> void {
+    unmap();
+    borrow(data, size);
+}
+
+/// the first edit of a mapped or borrowed buffer copies its bytes, the
+/// later ones change that copy in place
+auto SrcBuffer::edit(const SrcEdit &edit) -> void {
+    if (m_mapped || m_data != m_storage.c_str() + m_skip) {
+        std::string contents(m_data, m_size);
+#if MCC_HAS_MMAP
+        if (m_mapped) ::munmap(const_cast<char *>(m_data - m_skip), m_mapped);
+#endif
+        m_mapped  = 0;
+        m_skip    = 0;
+        m_storage = std::move(contents);
+    }
+
+    m_storage.replace(m_skip + edit.offset, edit.removed, edit.inserted);
+    m_data = m_storage.c_str() + m_skip;
+    m_size = m_storage.size() - m_skip;
+}
+
+SrcBuffer::~SrcBuffer() {
+#if MCC_HAS_MMAP
+    if (m_mapped) ::munmap(const_cast<char *>(m_data - m_skip), m_mapped);
+#endif
+}
+
+/// reuses the storage of an earlier copy
+auto SrcBuffer::assign(std::string_view source) -> void {
+    m_storage.assign(source.data(), source.size());
+    m_data = m_storage.c_str();
+    m_size = source.size();
+    m_skip = 0;
+    skip_bom();
+}
+
+auto SrcBuffer::borrow(const char *data, size_t size) -> void {
+    if (data[size] != '\0') panic("source to borrow is not terminated by a '\\0'");
+    m_data = data;
+    m_size = size;
+    m_skip = 0;
+    skip_bom();
+}
+
+auto SrcBuffer::unmap() -> void {
+#if MCC_HAS_MMAP
+    if (m_mapped) ::munmap(const_cast<char *>(m_data - m_skip), m_mapped);
+#endif
+    m_mapped = 0;
+}
+
+auto SrcBuffer::skip_bom() -> void {
+    if (m_size >= 3 && std::memcmp(m_data, "\xef\xbb\xbf", 3) == 0) {
+        m_skip = 3;
+        m_data += 3;
+        m_size -= 3;
+    }
+}
+
+/// SrcReader
+/// ----------------------------------------------------------------------------
+SrcReader::SrcReader(int fd, std::string srcfile)
+    : m_fd(fd),
+      m_eof(false),
+      m_state(State::Code),
+      m_srcfile(std::move(srcfile)),
+      m_base(0),
+      m_cut(0),
+      m_scanned(0),
+      m_safe(0),
+      m_saved('\0') {}
+
+SrcReader::~SrcReader() {
+#if MCC_HAS_MMAP
+    if (m_fd > STDERR_FILENO) ::close(m_fd);
+#endif
+}
+
+auto SrcReader::text(uint32_t offset, size_t length) const -> std::string_view {
+    if (offset >= m_base && offset + length <= m_base + m_cut) return {m_window.data() + (offset - m_base), length};
+
+    auto iter = std::lower_bound(m_index.begin(), m_index.end(), std::make_pair(offset, uint32_t(0)));
+    if (iter == m_index.end() || iter->first != offset) return {};
+    return std::string_view(m_kept).substr(iter->second, length);
+}
+
+auto SrcReader::keep(uint32_t offset, size_t length) -> void {
+    const auto text = this->text(offset, length);
+    if (text.empty() || (!m_index.empty() && m_index.back().first >= offset)) return;
+
+    m_index.emplace_back(offset, static_cast<uint32_t>(m_kept.size()));
+    m_kept.append(text);
+}
+
+auto SrcReader::advance(std::vector<uint32_t> &lines) -> bool {
+    if (m_cut < m_window.size()) m_window[m_cut] = m_saved;
+    if (!m_eof) read(lines);
+
+    // nothing left, keep the last window around for diagnostics
+    if (m_eof && m_cut == m_window.size()) return false;
+
+    m_window.erase(0, m_cut);
+    m_base += static_cast<uint32_t>(m_cut);
+    m_scanned -= m_cut;
+    m_safe = m_safe > m_cut ? m_safe - m_cut : 0;
+
+    while (m_safe == 0 && !m_eof) read(lines);
+
+    m_cut = m_eof ? m_window.size() : m_safe;
+    if (m_cut < m_window.size()) {
+        m_saved         = m_window[m_cut];
+        m_window[m_cut] = '\0';
+    }
+    return m_cut != 0;
+}
+
+auto SrcReader::read(std::vector<uint32_t> &lines) -> void {
+    const auto size = m_window.size();
+    m_window.resize(size + kChunkSize);
+
+#if MCC_HAS_MMAP
+    auto count = ::read(m_fd, &m_window[size], kChunkSize);
+    while (count < 0 && errno == EINTR) count = ::read(m_fd, &m_window[size], kChunkSize);
+    if (count < 0) panic("failed to read file " + m_srcfile);
+#else
+    auto count = 0;
+    panic("streaming input is not supported on this platform");
+#endif
+
+    m_window.resize(size + count);
+    m_eof = count == 0;
+
+    if (m_base == 0 && size == 0 && m_window.compare(0, 3, "\xef\xbb\xbf") == 0) {
+        m_window.erase(0, 3);
+        count -= 3;
+    }
+
+    if (uint64_t(m_base) + m_window.size() >= std::numeric_limits<uint32_t>::max()) {
+        panic("source file too large " + m_srcfile);
+    }
+
+    simd::scan_lines(m_window.data() + size, count, m_base + static_cast<uint32_t>(size), lines);
+    scan();
+}
+
+/// tracks comments and literals, and remembers the last newline outside of
+/// them, i.e. the last place the window can be cut without splitting a token.
+auto SrcReader::scan() -> void {
+    while (m_scanned < m_window.size()) {
+        const char ch = m_window[m_scanned++];
+        switch (m_state) {
+            case State::Slash:
+                if (ch == '/') {
+                    m_state = State::LineComment;
+                    break;
+                }
+                if (ch == '*') {
+                    m_state = State::BlockComment;
+                    break;
+                }
+                m_state = State::Code;
+                [[fallthrough]];
+            case State::Code:
+                if (ch == '\n') m_safe = m_scanned;
+                if (ch == '/') m_state = State::Slash;
+                if (ch == '"') m_state = State::Str;
+                if (ch == '\'') m_state = State::Char;
+                break;
+            case State::LineComment:
+                if (ch == '\n') m_state = State::Code, m_safe = m_scanned;
+                break;
+            case State::BlockComment:
+                if (ch == '*') m_state = State::Star;
+                break;
+            case State::Star:
+                m_state = ch == '/' ? State::Code : ch == '*' ? State::Star : State::BlockComment;
+                break;
+            case State::Str:
+                if (ch == '\\') m_state = State::StrEscape;
+                if (ch == '"') m_state = State::Code;
+                break;
+            case State::Char:
+                if (ch == '\\') m_state = State::CharEscape;
+                if (ch == '\'') m_state = State::Code;
+                break;
+            case State::StrEscape: m_state = State::Str; break;
+            case State::CharEscape: m_state = State::Char; break;
+        }
+    }
+}
+
+/// SourceManager
+/// ----------------------------------------------------------------------------
+auto SourceManager::instance() -> SourceManager & {
+    static SourceManager manager;
+    return manager;
+}
+
+auto SourceManager::Entries::push_back(Entry entry) -> FileID {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_size == kBlocks << kBlockBits) panic("too many source files");
+    auto &block = m_blocks[m_size >> kBlockBits];
+    if (!block) block.reset(new Entry[kBlockMask + 1]);
+    block[m_size & kBlockMask] = std::move(entry);
+    return m_size++;
+}
+
+auto SourceManager::identify(const char *srcfile, std::string &canonical, FileKey &key) -> bool {
+#if MCC_HAS_MMAP
+    struct stat st;
+    if (::stat(srcfile, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+
+    auto path = ::realpath(srcfile, nullptr);
+    if (path == nullptr) return false;
+    canonical = path;
+    std::free(path);
+
+#if defined(__APPLE__)
+    const auto mtime = st.st_mtimespec;
+#else
+    const auto mtime = st.st_mtim;
+#endif
+    key = {static_cast<uint64_t>(st.st_dev), static_cast<uint64_t>(st.st_ino),
+           static_cast<int64_t>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec, static_cast<uint64_t>(st.st_size)};
+    return true;
+#else
+    return false;
+#endif
+}
+
+auto SourceManager::load(const char *srcfile) -> FileID {
+    if (m_filesystem) {
+        auto iter = m_virtual.find(srcfile);
+        if (iter != m_virtual.end()) return check(iter->second);
+
+        if (auto source = m_filesystem(srcfile)) {
+            const auto file = add(srcfile, *source);
+            m_virtual.emplace(srcfile, file);
+            return file;
+        }
+    }
+
+    auto canonical       = std::string();
+    auto key             = FileKey{};
+    const auto cacheable = identify(srcfile, canonical, key);
+
+    if (cacheable) {
+        auto iter = m_cache.find(canonical);
+        if (iter != m_cache.end() && m_files[iter->second].key == key) return check(iter->second);
+    }
+
+    auto buffer = std::make_unique<SrcBuffer>(srcfile);
+    if (buffer->size() >= std::numeric_limits<uint32_t>::max()) {
+        panic(std::string("source file too large ") + srcfile);
+    }
+
+    std::vector<uint32_t> lines{0};
+    simd::scan_lines(buffer->data(), buffer->size(), 0, lines);
+
+    const auto file = m_files.push_back({srcfile, key, std::move(buffer), nullptr, std::move(lines)});
+
+    if (cacheable) m_cache[canonical] = file;
+    return check(file);
+}
+
+auto SourceManager::add(std::string srcfile, std::string_view source) -> FileID {
+    if (source.size() >= std::numeric_limits<uint32_t>::max()) {
+        panic("source file too large " + srcfile);
+    }
+    return add(std::move(srcfile), std::make_unique<SrcBuffer>(source));
+}
+
+auto SourceManager::add(std::string srcfile, const char *source, size_t size) -> FileID {
+    if (size >= std::numeric_limits<uint32_t>::max()) {
+        panic("source file too large " + srcfile);
+    }
+    return add(std::move(srcfile), std::make_unique<SrcBuffer>(source, size));
+}
+
+auto SourceManager::add(std::string srcfile, std::unique_ptr<SrcBuffer> buffer) -> FileID {
+    std::vector<uint32_t> lines{0};
+    simd::scan_lines(buffer->data(), buffer->size(), 0, lines);
+
+    Entry entry{std::move(srcfile), {}, std::move(buffer), nullptr, std::move(lines)};
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_released.empty()) {
+        lock.unlock();
+        return check(m_files.push_back(std::move(entry)));
+    }
+
+    const auto file = m_released.back();
+    m_released.pop_back();
+    lock.unlock();
+    m_files[file] = std::move(entry);
+    return check(file);
+}
+
+/// frees what a source from `add()` holds, a later `add()` reuses its id.
+auto SourceManager::release(FileID file) -> void {
+    m_files[file] = Entry{};
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_released.push_back(file);
+}
+
+/// edits the buffer in place. The line starts before the edit are kept and
+/// the ones after it moved, only the inserted text is scanned for new ones.
+/// A later `load()` of the file reads it again rather than see the edit.
+auto SourceManager::update(FileID file, const SrcEdit &edit) -> void {
+    auto &entry = m_files[file];
+    if (!entry.buffer) panic("can not edit a streamed source " + entry.srcfile);
+
+    const auto size = entry.buffer->size();
+    if (edit.offset > size || edit.removed > size - edit.offset) panic("edit out of range of " + entry.srcfile);
+    if (size - edit.removed + edit.inserted.size() >= std::numeric_limits<uint32_t>::max()) {
+        panic("source file too large " + entry.srcfile);
+    }
+
+    entry.buffer->edit(edit);
+    entry.key = {};
+
+    auto &lines      = entry.lines;
+    const auto after = std::upper_bound(lines.begin(), lines.end(), edit.offset + edit.removed) - lines.begin();
+    const auto first = std::upper_bound(lines.begin(), lines.begin() + after, edit.offset) - lines.begin();
+    const auto delta = static_cast<uint32_t>(edit.inserted.size() - edit.removed);
+    for (auto iter = lines.begin() + after; iter != lines.end(); ++iter) *iter += delta;
+
+    std::vector<uint32_t> added;
+    simd::scan_lines(edit.inserted.data(), edit.inserted.size(), edit.offset, added);
+    lines.erase(lines.begin() + first, lines.begin() + after);
+    lines.insert(lines.begin() + first, added.begin(), added.end());
+    validate(file);
+}
+
+/// re-scans the line starts into the memory of the old ones, so a caller
+/// reusing the entry for sources of about the same size allocates nothing.
+auto SourceManager::rebind(FileID file, std::string_view source) -> void {
+    auto &entry = m_files[file];
+    if (!entry.buffer) panic("can not rebind a streamed source " + entry.srcfile);
+    if (source.size() >= std::numeric_limits<uint32_t>::max()) {
+        panic("source file too large " + entry.srcfile);
+    }
+
+    entry.buffer->rebind(source);
+    rescan(file);
+}
+
+auto SourceManager::rebind(FileID file, const char *source, size_t size) -> void {
+    auto &entry = m_files[file];
+    if (!entry.buffer) panic("can not rebind a streamed source " + entry.srcfile);
+    if (size >= std::numeric_limits<uint32_t>::max()) {
+        panic("source file too large " + entry.srcfile);
+    }
+
+    entry.buffer->rebind(source, size);
+    rescan(file);
+}
+
+auto SourceManager::rescan(FileID file) -> void {
+    auto &entry = m_files[file];
+    entry.lines.resize(1);
+    simd::scan_lines(entry.buffer->data(), entry.buffer->size(), 0, entry.lines);
+    validate(file);
+}
+
+/// files served before stay registered, only later loads see the new hook.
+auto SourceManager::mount(FileSystem filesystem) -> void {
+    m_filesystem = std::move(filesystem);
+    m_virtual.clear();
+}
+
+/// reads the files level by level, each level as one batch, skipping files
+/// that are already loaded. Failures are left to report for `load()`.
+auto SourceManager::prefetch(const std::vector<std::string> &srcfiles) -> void {
+    auto pending = srcfiles;
+    while (!pending.empty()) {
+        std::vector<FileRead> batch;
+        std::vector<std::pair<std::string, FileKey>> keys;
+        for (const auto &srcfile : pending) {
+            if (m_filesystem && (m_virtual.count(srcfile) || m_filesystem(srcfile.c_str()))) continue;
+
+            auto canonical = std::string();
+            auto key       = FileKey{};
+            if (!identify(srcfile.c_str(), canonical, key)) continue;
+            if (key.size == 0 || key.size >= std::numeric_limits<uint32_t>::max()) continue;
+
+            auto iter = m_cache.find(canonical);
+            if (iter != m_cache.end() && m_files[iter->second].key == key) continue;
+            if (std::any_of(keys.begin(), keys.end(), [&](const auto &k) { return k.first == canonical; })) continue;
+
+            batch.push_back({srcfile.c_str(), static_cast<size_t>(key.size), {}, false});
+            keys.emplace_back(std::move(canonical), key);
+        }
+
+        read_files(batch);
+
+        std::vector<std::string> next;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (!batch[i].ok) continue;
+
+            auto buffer = std::make_unique<SrcBuffer>(std::move(batch[i].data));
+            std::vector<uint32_t> lines{0};
+            simd::scan_lines(buffer->data(), buffer->size(), 0, lines);
+            detail::scan_includes(buffer->data(), buffer->data() + buffer->size(), next);
+
+            m_cache[keys[i].first] = m_files.push_back({batch[i].path, keys[i].second, std::move(buffer), nullptr, std::move(lines)});
+        }
+        pending = std::move(next);
+    }
+}
+
+auto SourceManager::prefetch(FileID file) -> void {
+    const auto &entry = m_files[file];
+    if (!entry.buffer) return;
+
+    std::vector<std::string> srcfiles;
+    detail::scan_includes(entry.buffer->data(), entry.buffer->data() + entry.buffer->size(), srcfiles);
+    if (!srcfiles.empty()) prefetch(srcfiles);
+}
+
+auto SourceManager::stream(const char *srcfile) -> FileID {
+#if MCC_HAS_MMAP
+    const auto use_stdin = std::strcmp(srcfile, "-") == 0;
+    const auto fd        = use_stdin ? STDIN_FILENO : ::open(srcfile, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) panic(std::string("failed to open file ") + srcfile);
+#else
+    const auto use_stdin = false, fd = -1;
+    panic("streaming input is not supported on this platform");
+#endif
+
+    const auto name = use_stdin ? std::string("<stdin>") : std::string(srcfile);
+    const auto file = m_files.push_back({name, {}, nullptr, std::make_unique<SrcReader>(fd, name), {0}});
+    advance(file);
+    return file;
+}
+
+auto SourceManager::keep(SrcLoc loc, size_t length) -> void {
+    auto &entry = m_files[loc.file];
+    if (entry.reader) entry.reader->keep(loc.offset, length);
+}
+
+auto SourceManager::advance(FileID file) -> bool {
+    auto &entry = m_files[file];
+    if (!entry.reader || !entry.reader->advance(entry.lines)) return false;
+
+    check(file);
+    return true;
+}
+
+/// validates what the lexer is about to see, a buffer once and a streamed
+/// source window by window. The windows never split a UTF-8 sequence since
+/// they are cut after a newline.
+auto SourceManager::check(FileID file) -> FileID {
+    auto &entry = m_files[file];
+    if (entry.checked) return file;
+
+    const auto data = entry.buffer ? entry.buffer->data() : entry.reader->data();
+    const auto size = entry.buffer ? entry.buffer->size() : entry.reader->size();
+    const auto base = entry.buffer ? 0 : entry.reader->base();
+    const auto bad  = simd::validate_utf8(data, size, entry.ascii);
+    if (bad != size) panic("invalid UTF-8 sequence.", {file, base + static_cast<uint32_t>(bad)});
+
+    entry.checked = entry.buffer != nullptr;
+    return file;
+}
+
+/// validates an edited or rebound buffer as `check()` does, but leaves an
+/// invalid sequence to the lexer, so an editor or a service is not stopped
+/// by one bad keystroke or snippet.
+auto SourceManager::validate(FileID file) -> void {
+    auto &entry     = m_files[file];
+    const auto size = entry.buffer->size();
+    const auto bad  = simd::validate_utf8(entry.buffer->data(), size, entry.ascii);
+    entry.invalid   = bad == size ? UINT32_MAX : static_cast<uint32_t>(bad);
+    entry.checked   = true;
+}
+
+auto SourceManager::resolve(SrcLoc loc) const -> ResolvedLoc {
+    const auto &entry = m_files[loc.file];
+    const auto &lines = entry.lines;
+    const auto size   = entry.buffer ? entry.buffer->size() : entry.reader->base() + entry.reader->size();
+
+    const auto line  = std::upper_bound(lines.begin(), lines.end(), loc.offset) - 1;
+    const auto first = *line;
+    const auto last  = line + 1 != lines.end() ? std::min<size_t>(line[1] - 1, size) : size;
+    const auto text  = entry.buffer ? std::string_view(entry.buffer->data() + first, last - first)
+                                    : entry.reader->text(first, last - first);
+
+    return {entry.srcfile, text, static_cast<size_t>(line - lines.begin() + 1), static_cast<size_t>(loc.offset - first + 1)};
+}
+
+}  // namespace mcc
\ No newline at end of file
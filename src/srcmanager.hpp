@@ -0,0 +1,262 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mcc {
+
+using FileID = uint32_t;
+
+/// SrcLoc
+/// ----------------------------------------------------------------------------
+/// A compact source location, the file and the byte offset inside of it. Line
+/// and column are only computed by `SourceManager::resolve()` when needed.
+struct SrcLoc {
+    FileID file;
+    uint32_t offset;
+};
+
+/// SrcEdit
+/// ----------------------------------------------------------------------------
+/// Replaces the `removed` bytes at `offset` of a source by `inserted`.
+struct SrcEdit {
+    uint32_t offset;
+    uint32_t removed;
+    std::string_view inserted;
+};
+
+/// ResolvedLoc
+/// ----------------------------------------------------------------------------
+struct ResolvedLoc {
+    std::string_view srcfile;
+    std::string_view line;  // text of the line, without the line break
+    size_t linenum;
+    size_t column;
+};
+
+/// SrcBuffer
+/// ----------------------------------------------------------------------------
+/// Owns the bytes of one source file. Regular files are mapped read-only,
+/// pipes and special files are read into memory. A source in memory is
+/// copied from a view, which is not read past its end, and borrowed from a
+/// pointer and a size only, with a '\0' after the bytes. Either way
+/// `data()[size()]` is always a readable '\0' sentinel. A UTF-8 byte order
+/// mark is not part of the data. The first `edit()` copies the bytes of a
+/// mapped or borrowed buffer.
+class SrcBuffer {
+public:
+    SrcBuffer(const char *srcfile);
+    SrcBuffer(std::string contents);
+    SrcBuffer(std::string_view source);
+    SrcBuffer(const char *data, size_t size);
+    ~SrcBuffer();
+    SrcBuffer(SrcBuffer &&)      = delete;
+    SrcBuffer(const SrcBuffer &) = delete;
+    auto operator=(SrcBuffer &&) -> SrcBuffer & = delete;
+    auto operator=(const SrcBuffer &) -> SrcBuffer & = delete;
+
+    inline auto data() const -> const char * { return m_data; }
+    inline auto size() const -> size_t { return m_size; }
+    inline auto mapped() const -> bool { return m_mapped != 0; }
+
+    auto edit(const SrcEdit &edit) -> void;
+    auto rebind(std::string_view source) -> void;
+    auto rebind(const char *data, size_t size) -> void;
+
+private:
+    auto assign(std::string_view source) -> void;
+    auto borrow(const char *data, size_t size) -> void;
+    auto unmap() -> void;
+    auto skip_bom() -> void;
+
+    const char *m_data;
+    size_t m_size;
+    size_t m_skip;          // bytes of a byte order mark in front of `m_data`
+    size_t m_mapped;        // length of the mapping, 0 if not mapped
+    std::string m_storage;  // fallback storage for non-mappable files and copied sources
+};
+
+/// SrcReader
+/// ----------------------------------------------------------------------------
+/// Reads a source in fixed-size chunks for the streaming mode, e.g. from a
+/// pipe. Only a window of the source is resident. The window is always cut
+/// right after a newline outside of comments and literals, so no token ever
+/// crosses it and the lexer only has to `advance()` between tokens. A window
+/// only grows beyond one chunk for a comment, literal or line that is longer.
+class SrcReader {
+public:
+    static constexpr size_t kChunkSize = 64 * 1024;
+
+    SrcReader(int fd, std::string srcfile);
+    ~SrcReader();
+    SrcReader(SrcReader &&)      = delete;
+    SrcReader(const SrcReader &) = delete;
+    auto operator=(SrcReader &&) -> SrcReader & = delete;
+    auto operator=(const SrcReader &) -> SrcReader & = delete;
+
+    /// window of the source visible to the lexer, `data()[size()]` is '\0'
+    inline auto data() const -> const char * { return m_window.data(); }
+    inline auto size() const -> size_t { return m_cut; }
+    inline auto base() const -> uint32_t { return m_base; }
+
+    /// text at [offset, offset + length) if still resident or kept, else empty
+    auto text(uint32_t offset, size_t length) const -> std::string_view;
+
+    /// copies resident text aside so `text()` finds it after the window moved
+    /// on, e.g. for the spelling of constants. Offsets must be increasing.
+    auto keep(uint32_t offset, size_t length) -> void;
+
+    /// discards the current window and moves to the next one, appending the
+    /// line starts of newly read bytes to `lines`. false at the end of input.
+    auto advance(std::vector<uint32_t> &lines) -> bool;
+
+private:
+    enum class State : uint8_t { Code, Slash, LineComment, BlockComment, Star, Str, StrEscape, Char, CharEscape };
+
+    auto read(std::vector<uint32_t> &lines) -> void;
+    auto scan() -> void;
+
+    int m_fd;
+    bool m_eof;
+    State m_state;
+    std::string m_srcfile;
+    std::string m_window;  // resident bytes, starting at offset `m_base`
+    uint32_t m_base;
+    size_t m_cut;      // end of the window visible to the lexer
+    size_t m_scanned;  // bytes of `m_window` already run through `scan()`
+    size_t m_safe;     // last position a window may be cut at, 0 if none
+    char m_saved;      // byte at `m_cut` replaced by the sentinel
+    std::string m_kept;                                  // text copied by `keep()`
+    std::vector<std::pair<uint32_t, uint32_t>> m_index;  // offset in the source -> position in `m_kept`
+};
+
+/// SourceManager
+/// ----------------------------------------------------------------------------
+/// Owns every source buffer loaded during the process, including the headers
+/// pulled in by `#include`, so token locations stay valid until exit. Loading
+/// a regular file again returns the same id as long as its canonical path,
+/// inode and mtime are unchanged. `prefetch()` reads a batch of files, or the
+/// ones a loaded file includes, and the files they include in turn, ahead of
+/// time so later loads find them.
+/// Sources opened with `stream()` are read piecewise instead, see `SrcReader`.
+///
+/// `update()` applies an edit to a source in place, the tokens lexed before
+/// are only right again once `relex()` moved them. `rebind()` points a
+/// source from `add()` at other bytes, for a caller that reuses one entry,
+/// see `LexContext`, and `release()` frees it once its tokens are gone.
+/// Entries never move, so `add()`, `rebind()` and `release()` may run on
+/// several threads at once, each on its own source, also while another
+/// thread loads files.
+///
+/// `add()` registers a source the caller already has in memory, and a file
+/// system hook installed with `mount()` lets `load()`, and with it
+/// `#include`, serve files from memory. Both copy a view. `add()` of a
+/// pointer and a size borrows the bytes instead, which must outlive the
+/// process' use of mcc and be followed by a '\0', as for `std::string` or
+/// string literals.
+class SourceManager {
+public:
+    /// returns the source of `path`, or nothing to fall back to the disk
+    using FileSystem = std::function<std::optional<std::string_view>(const char *path)>;
+
+    static auto instance() -> SourceManager &;
+
+    auto load(const char *srcfile) -> FileID;
+    auto add(std::string srcfile, std::string_view source) -> FileID;
+    auto add(std::string srcfile, const char *source, size_t size) -> FileID;
+    auto update(FileID file, const SrcEdit &edit) -> void;
+    auto rebind(FileID file, std::string_view source) -> void;
+    auto rebind(FileID file, const char *source, size_t size) -> void;
+    auto release(FileID file) -> void;
+    auto mount(FileSystem filesystem) -> void;
+    auto prefetch(const std::vector<std::string> &srcfiles) -> void;
+    auto prefetch(FileID file) -> void;
+    auto stream(const char *srcfile) -> FileID;
+    auto advance(FileID file) -> bool;
+    auto resolve(SrcLoc loc) const -> ResolvedLoc;
+    auto keep(SrcLoc loc, size_t length) -> void;
+
+    inline auto buffer(FileID file) const -> const SrcBuffer & { return *m_files[file].buffer; }
+    inline auto reader(FileID file) const -> const SrcReader * { return m_files[file].reader.get(); }
+    inline auto srcfile(FileID file) const -> std::string_view { return m_files[file].srcfile; }
+    inline auto ascii(FileID file) const -> bool { return m_files[file].ascii; }
+
+    /// first byte of an invalid UTF-8 sequence that `update()` or `rebind()`
+    /// let in, for the lexer to report, `UINT32_MAX` if there is none
+    inline auto invalid(FileID file) const -> uint32_t { return m_files[file].invalid; }
+
+    /// source text at `loc`, see `SrcReader::text()` for streamed sources
+    inline auto text(SrcLoc loc, size_t length) const -> std::string_view {
+        const auto &entry = m_files[loc.file];
+        if (entry.buffer) return {entry.buffer->data() + loc.offset, length};
+        return entry.reader->text(loc.offset, length);
+    }
+
+private:
+    SourceManager() = default;
+
+    /// identity of a file on disk, a load is shared while it is unchanged
+    struct FileKey {
+        uint64_t device;
+        uint64_t inode;
+        int64_t mtime;
+        uint64_t size;
+
+        inline auto operator==(const FileKey &other) const -> bool {
+            return device == other.device && inode == other.inode && mtime == other.mtime && size == other.size;
+        }
+    };
+
+    static auto identify(const char *srcfile, std::string &canonical, FileKey &key) -> bool;
+    auto add(std::string srcfile, std::unique_ptr<SrcBuffer> buffer) -> FileID;
+    auto check(FileID file) -> FileID;
+    auto rescan(FileID file) -> void;
+    auto validate(FileID file) -> void;
+
+    struct Entry {
+        std::string srcfile;
+        FileKey key;
+        std::unique_ptr<SrcBuffer> buffer;        // whole file, null in streaming mode
+        std::unique_ptr<SrcReader> reader;        // streaming mode only
+        std::vector<uint32_t> lines;              // offset of every line start, built on load
+        bool ascii       = true;                  // no byte >= 0x80, per window in streaming mode
+        bool checked     = false;                 // validated as UTF-8, see `check()`
+        uint32_t invalid = UINT32_MAX;            // see `invalid()`
+    };
+
+    /// Entries in fixed blocks that never move, so a thread can use the
+    /// entries it has while another one adds more. Only adding is locked.
+    class Entries {
+    public:
+        inline auto operator[](FileID file) -> Entry & { return m_blocks[file >> kBlockBits][file & kBlockMask]; }
+        inline auto operator[](FileID file) const -> const Entry & { return m_blocks[file >> kBlockBits][file & kBlockMask]; }
+
+        auto push_back(Entry entry) -> FileID;
+
+    private:
+        static constexpr uint32_t kBlockBits = 10;
+        static constexpr uint32_t kBlockMask = (1u << kBlockBits) - 1;
+        static constexpr uint32_t kBlocks    = 1u << 12;
+
+        std::mutex m_mutex;
+        std::array<std::unique_ptr<Entry[]>, kBlocks> m_blocks;
+        uint32_t m_size = 0;
+    };
+
+    Entries m_files;
+    std::unordered_map<std::string, FileID> m_cache;    // canonical path -> latest load
+    std::unordered_map<std::string, FileID> m_virtual;  // path -> file served by `m_filesystem`
+    std::mutex m_mutex;                                 // guards `m_released`
+    std::vector<FileID> m_released;                     // entries `add()` can reuse
+    FileSystem m_filesystem;
+};
+
+}  // namespace mcc
\ No newline at end of file
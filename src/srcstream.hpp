@@ -1,43 +1,97 @@
 #pragma once
 
-#include <string>
+#include "simd.hpp"
+#include "srcmanager.hpp"
 
 namespace mcc {
 
-struct SrcLoc {
-    const char *srcfile;
-    const char *current;
-    const char *lineptr;
-    size_t linenum;
-};
-
 class SrcStream {
 public:
     SrcStream(const char *srcfile);
+    SrcStream(std::string_view source, std::string srcfile);
+    SrcStream(FileID file);
     ~SrcStream() = default;
+    SrcStream(SrcStream &&)      = default;
+    SrcStream(const SrcStream &) = delete;
+    auto operator=(SrcStream &&) -> SrcStream & = default;
+    auto operator=(const SrcStream &) -> SrcStream & = delete;
+
+    inline auto operator*() const -> char { return *m_current; }
+    inline auto operator++() -> SrcStream & { return ++m_current, *this; }
+    inline auto operator+=(size_t count) -> SrcStream & { return m_current += count, *this; }
+    inline operator bool() const { return *m_current != '\0'; }
 
-    auto operator*() const -> char;
-    auto operator++() -> SrcStream &;
-    auto operator++(int) -> SrcStream;
-    operator bool() const;
+    inline auto reset(SrcLoc loc) -> void { m_current = m_first + (loc.offset - m_base); }
+    inline auto location() const -> SrcLoc { return {m_file, m_base + static_cast<uint32_t>(m_current - m_first)}; }
+    inline auto current() const -> const char * { return m_current; }
+    inline auto file() const -> FileID { return m_file; }
+    inline auto ascii() const -> bool { return m_ascii; }
+    inline auto streaming() const -> bool { return m_reader != nullptr; }
 
-    auto reset(SrcLoc) -> void;
     auto match(char) -> bool;
     auto match(char, char) -> bool;
     auto match(char, char, char) -> bool;
-    [[nodiscard]] auto location() const -> SrcLoc;
+
+    auto refill() -> bool;
+
+    /// also moves a streaming source on to its next window, which is only
+    /// ever cut between tokens, so call it at token boundaries.
+    inline auto skip_blank() -> void {
+        m_current = simd::skip_blank(m_current, m_last);
+        if (m_current == m_last && refill()) skip_blank();
+    }
+    /// bytes >= 0x80 only continue an identifier in a source that has them.
+    inline auto skip_ident() -> void {
+        m_current = simd::skip_ident(m_current, m_last);
+        if (m_ascii) return;
+        while (static_cast<unsigned char>(*m_current) >= 0x80) m_current = simd::skip_ident(m_current + 1, m_last);
+    }
+    inline auto skip_number() -> void { m_current = simd::skip_number(m_current, m_last); }
+    /// past the end of a `//` comment, its '\n' included
+    inline auto skip_line_comment() -> void {
+        m_current = simd::skip_line(m_current, m_last);
+        match('\n');
+    }
+    /// past the `*/` of a block comment, false if the source ends first
+    inline auto skip_block_comment() -> bool {
+        for (;; ++m_current) {
+            m_current = simd::skip_comment(m_current, m_last);
+            if (*m_current == '\0') return false;
+            if (match('*', '/')) return true;
+        }
+    }
 
     template <typename Pred>
     auto skip(Pred pred) -> void {
-        while (pred(*m_current)) ++*this;
+        while (pred(*m_current)) ++m_current;
     }
 
 private:
-    std::string m_source;
-    const char *m_srcfile;
+    FileID m_file;
+    uint32_t m_base;             // offset of `m_first` in the file
+    const SrcReader *m_reader;  // streaming mode only
+    bool m_ascii;               // no byte >= 0x80 in [m_first, m_last)
+    const char *m_first;
     const char *m_current;
-    const char *m_lineptr;
-    size_t m_linenum;
+    const char *m_last;
 };
 
-}  // namespace mcc
\ No newline at end of file
+inline auto SrcStream::match(char c1) -> bool {
+    if (m_current[0] != c1) return false;
+    m_current += 1;
+    return true;
+}
+
+inline auto SrcStream::match(char c1, char c2) -> bool {
+    if (m_current[0] != c1 || m_current[1] != c2) return false;
+    m_current += 2;
+    return true;
+}
+
+inline auto SrcStream::match(char c1, char c2, char c3) -> bool {
+    if (m_current[0] != c1 || m_current[1] != c2 || m_current[2] != c3) return false;
+    m_current += 3;
+    return true;
+}
+
+}  // namespace mcc
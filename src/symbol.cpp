@@ -0,0 +1,161 @@
+#include "symbol.hpp"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace mcc {
+
+namespace detail {
+
+constexpr uint32_t kShardBits = 4;
+constexpr uint32_t kShards    = 1u << kShardBits;
+constexpr size_t kBlockSize   = size_t(64) << 10;
+constexpr size_t kCacheSize   = 1024;
+
+/// FNV-1a, identifiers are short
+static auto hash(std::string_view spelling) -> uint32_t {
+    uint32_t result = 2166136261u;
+    for (auto ch : spelling) result = (result ^ static_cast<unsigned char>(ch)) * 16777619u;
+    return result;
+}
+
+/// SymbolTable
+/// ----------------------------------------------------------------------------
+/// Split into shards by hash, each with its own lock, open addressed table and
+/// storage for the spellings. The low bits of an id name its shard, the rest
+/// its index there. Index 0 of shard 0 is the empty name. Entries never
+/// change once added, so each thread keeps a small cache of the symbols it
+/// interned last and only takes a lock when that misses.
+class SymbolTable {
+public:
+    static auto instance() -> SymbolTable &;
+
+    auto intern(std::string_view spelling) -> uint32_t;
+    auto spelling(uint32_t id) -> std::string_view;
+
+private:
+    SymbolTable();
+
+    struct Entry {
+        const char *data;
+        uint32_t size;
+        uint32_t hash;  // kept to compare and to rehash without the spelling
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::vector<Entry> entries;
+        std::vector<uint32_t> slots;  // index into `entries` + 1, 0 if free
+        std::vector<std::unique_ptr<char[]>> blocks;
+        size_t used = kBlockSize;  // bytes used in `blocks.back()`
+
+        auto store(std::string_view spelling) -> const char *;
+        auto grow() -> void;
+    };
+
+    std::array<Shard, kShards> m_shards;
+};
+
+auto SymbolTable::instance() -> SymbolTable & {
+    static SymbolTable table;
+    return table;
+}
+
+SymbolTable::SymbolTable() {
+    for (auto &shard : m_shards) shard.slots.assign(1024, 0);
+    m_shards[0].entries.push_back({"", 0, hash({})});
+}
+
+/// a spelling longer than a block gets a block of its own, put in front of
+/// the one being filled so that one stays `blocks.back()`
+auto SymbolTable::Shard::store(std::string_view spelling) -> const char * {
+    if (spelling.size() > kBlockSize) {
+        auto iter = blocks.emplace(blocks.empty() ? blocks.end() : blocks.end() - 1, new char[spelling.size()]);
+        std::copy(spelling.begin(), spelling.end(), iter->get());
+        return iter->get();
+    }
+    if (spelling.size() > kBlockSize - used) {
+        blocks.emplace_back(new char[kBlockSize]);
+        used = 0;
+    }
+    auto result = blocks.back().get() + used;
+    std::copy(spelling.begin(), spelling.end(), result);
+    used += spelling.size();
+    return result;
+}
+
+auto SymbolTable::Shard::grow() -> void {
+    slots.assign(slots.size() * 2, 0);
+    const auto mask = slots.size() - 1;
+    for (uint32_t index = 0; index < entries.size(); ++index) {
+        auto slot = (entries[index].hash >> kShardBits) & mask;
+        while (slots[slot]) slot = (slot + 1) & mask;
+        slots[slot] = index + 1;
+    }
+}
+
+auto SymbolTable::intern(std::string_view spelling) -> uint32_t {
+    if (spelling.empty()) return 0;
+
+    struct Cached {
+        Entry entry;
+        uint32_t id;
+    };
+    thread_local std::array<Cached, kCacheSize> cache{};
+
+    const auto code = hash(spelling);
+    auto &cached    = cache[code % kCacheSize];
+    if (cached.entry.data && cached.entry.hash == code && std::string_view(cached.entry.data, cached.entry.size) == spelling) {
+        return cached.id;
+    }
+
+    const auto id = code & (kShards - 1);
+    auto &shard   = m_shards[id];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto mask = shard.slots.size() - 1;
+    auto slot       = (code >> kShardBits) & mask;
+    for (; shard.slots[slot]; slot = (slot + 1) & mask) {
+        const auto index  = shard.slots[slot] - 1;
+        const auto &entry = shard.entries[index];
+        if (entry.hash == code && std::string_view(entry.data, entry.size) == spelling) {
+            cached = {entry, index << kShardBits | id};
+            return cached.id;
+        }
+    }
+
+    const auto index = static_cast<uint32_t>(shard.entries.size());
+    shard.entries.push_back({shard.store(spelling), static_cast<uint32_t>(spelling.size()), code});
+    shard.slots[slot] = index + 1;
+    cached            = {shard.entries.back(), index << kShardBits | id};
+    if (shard.entries.size() * 2 > shard.slots.size()) shard.grow();
+    return cached.id;
+}
+
+auto SymbolTable::spelling(uint32_t id) -> std::string_view {
+    auto &shard = m_shards[id & (kShards - 1)];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto &entry = shard.entries[id >> kShardBits];
+    return {entry.data, entry.size};
+}
+
+}  // namespace detail
+
+auto Symbol::intern(std::string_view spelling) -> Symbol {
+    return Symbol(detail::SymbolTable::instance().intern(spelling));
+}
+
+auto Symbol::string() const -> std::string_view {
+    return detail::SymbolTable::instance().spelling(m_id);
+}
+
+extern auto operator<<(std::ostream &os, Symbol symbol) -> std::ostream & {
+    return os << symbol.string();
+}
+
+}  // namespace mcc
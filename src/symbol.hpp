@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string_view>
+
+namespace mcc {
+
+/// Symbol
+/// ----------------------------------------------------------------------------
+/// 32-bit id of an interned identifier, equal spellings get equal ids for the
+/// whole process. The lexer interns every identifier once, so macros, scopes
+/// and the AST compare and hash ids instead of strings. The default symbol is
+/// the empty name.
+class Symbol {
+public:
+    constexpr Symbol() : m_id(0) {}
+
+    /// thread safe, the parallel lexer interns from all of its threads
+    static auto intern(std::string_view spelling) -> Symbol;
+
+    inline auto id() const -> uint32_t { return m_id; }
+    inline auto empty() const -> bool { return m_id == 0; }
+    auto string() const -> std::string_view;
+
+    inline auto operator==(Symbol other) const -> bool { return m_id == other.m_id; }
+    inline auto operator!=(Symbol other) const -> bool { return m_id != other.m_id; }
+
+private:
+    constexpr explicit Symbol(uint32_t id) : m_id(id) {}
+
+    uint32_t m_id;
+};
+
+extern auto operator<<(std::ostream &, Symbol) -> std::ostream &;
+
+}  // namespace mcc
+
+template <>
+struct std::hash<mcc::Symbol> {
+    auto operator()(mcc::Symbol symbol) const noexcept -> size_t { return symbol.id(); }
+};
@@ -6,30 +6,110 @@
 
 namespace mcc {
 
-TkStream::TkStream(std::vector<Token> &&tokens)
-    : m_tokens(std::move(tokens)), m_current(0) {}
+namespace detail {
+
+/// replays tokens lexed before, e.g. an included file from the cache
+class BufferSource : public TokenSource {
+public:
+    BufferSource(TokenBuffer &&tokens)
+        : m_tokens(std::move(tokens)), m_next(0), m_next_constant(0), m_next_symbol(0), m_next_literal(0) {}
+
+    auto next() -> Token override {
+        if (m_next == m_tokens.size()) return {TokenKind::Eof, 0, 0, m_tokens.empty() ? SrcLoc{} : m_tokens.loc(m_tokens.size() - 1)};
+        if (m_tokens.kind(m_next) == TokenKind::Const) m_value.constant = m_tokens.constants()[m_next_constant++];
+        if (m_tokens.kind(m_next) == TokenKind::Ident) m_value.symbol = m_tokens.symbols()[m_next_symbol++];
+        if (is_literal(m_tokens.kind(m_next))) m_value.literal = m_tokens.literals()[m_next_literal++];
+        return m_tokens[m_next++];
+    }
+    auto value() const -> TokenValue override { return m_value; }
+
+private:
+    TokenBuffer m_tokens;
+    size_t m_next;
+    size_t m_next_constant;
+    size_t m_next_symbol;
+    size_t m_next_literal;
+    TokenValue m_value;
+};
+
+}  // namespace detail
+
+TkStream::TkStream(std::unique_ptr<TokenSource> source)
+    : m_source(std::move(source)), m_current(0), m_end(0) {}
+
+TkStream::TkStream(TokenBuffer &&tokens)
+    : TkStream(std::make_unique<detail::BufferSource>(std::move(tokens))) {}
+
+auto TkStream::pull() -> void {
+    while (m_end <= m_current) {
+        const auto token = m_source->next();
+        const auto slot  = m_end++ % kWindow;
+        m_kinds[slot]    = token.kind;
+        m_lengths[slot]  = token.length;
+        m_flags[slot]    = token.flags;
+        m_locs[slot]     = token.loc;
+        if (has_value(token.kind)) m_values[slot] = m_source->value();
+    }
+}
+
+auto TkStream::reset(size_t loc) -> void {
+    if (loc + kWindow < m_end) panic("token stream reset beyond its window");
+    m_current = loc;
+}
 
 auto TkStream::match(TokenKind kind) -> bool {
-    bool result = m_current < m_tokens.size() && peek().kind == kind;
+    bool result = peek_kind() == kind;
     if (result) ++m_current;
     return result;
 }
 
 auto TkStream::match(TokenKind kind, std::string &string) -> bool {
-    bool result = m_current < m_tokens.size() && peek().kind == kind;
+    bool result = peek_kind() == kind;
+    if (result) string = take().string();
+    return result;
+}
+
+auto TkStream::match(TokenKind kind, std::string_view &string) -> bool {
+    bool result = peek_kind() == kind;
+    if (result) string = take().string();
+    return result;
+}
+
+auto TkStream::match(TokenKind kind, Symbol &symbol) -> bool {
+    bool result = peek_kind() == kind;
+    if (result) {
+        symbol = peek_symbol();
+        ++m_current;
+    }
+    return result;
+}
+
+auto TkStream::match(TokenKind kind, Literal &literal) -> bool {
+    bool result = peek_kind() == kind;
     if (result) {
-        string = peek().string;
+        literal = peek_literal();
         ++m_current;
     }
     return result;
 }
 
 auto TkStream::expect(TokenKind kind, const std::string &msg) -> void {
-    if (m_current < m_tokens.size() && peek().kind != kind) {
-        panic(msg, peek().loc);
+    if (*this && peek_kind() != kind) {
+        panic(msg, peek_loc());
     } else {
         ++m_current;
     }
 }
 
+auto TkStream::take(TokenBuffer &tokens) -> void {
+    tokens.push_back(peek(), m_values[m_current % kWindow]);
+    ++m_current;
+}
+
+auto TkStream::collect() -> TokenBuffer {
+    TokenBuffer result;
+    while (*this) take(result);
+    return result;
+}
+
 }  // namespace mcc
\ No newline at end of file
@@ -1,42 +1,100 @@
 #pragma once
+#include <array>
+#include <memory>
 #include <vector>
 
 #include "srcstream.hpp"
 #include "token.hpp"
+#include "tokenbuffer.hpp"
 
 namespace mcc {
 
+/// TokenSource
+/// ----------------------------------------------------------------------------
+/// Produces tokens one at a time for a `TkStream`. Once exhausted `next()`
+/// keeps returning an `Eof` token. `value()` belongs to the token `next()`
+/// returned last, if that `has_value()`.
+class TokenSource {
+public:
+    virtual ~TokenSource() = default;
+
+    virtual auto next() -> Token = 0;
+    virtual auto value() const -> TokenValue = 0;
+};
+
 /// TkStream
 /// ----------------------------------------------------------------------------
+/// Pulls tokens from its source on demand. Only a window of the last
+/// `kWindow` tokens is kept, which bounds how far `reset()` can go back, so
+/// the memory used does not grow with the size of the source.
 class TkStream {
 public:
-    TkStream(std::vector<Token> &&tokens);
+    static constexpr size_t kWindow = 64;
+
+    TkStream(std::unique_ptr<TokenSource> source);
+    TkStream(TokenBuffer &&tokens);
     ~TkStream() = default;
+    TkStream(TkStream &&)      = default;
+    TkStream(const TkStream &) = delete;
+    auto operator=(TkStream &&) -> TkStream & = default;
+    auto operator=(const TkStream &) -> TkStream & = delete;
 
-    inline operator bool() const { return m_current < m_tokens.size(); }
-    inline auto peek() -> Token { return m_tokens[m_current]; }
-    inline auto next() -> Token { return m_tokens[m_current++]; }
-    inline auto reset(size_t loc) -> void { m_current = loc; }
+    inline operator bool() { return peek_kind() != TokenKind::Eof; }
+    inline auto peek() -> Token {
+        fill();
+        const auto slot = m_current % kWindow;
+        return {m_kinds[slot], m_lengths[slot], m_flags[slot], m_locs[slot]};
+    }
+    inline auto peek_kind() -> TokenKind { return fill(), m_kinds[m_current % kWindow]; }
+    inline auto peek_loc() -> SrcLoc { return fill(), m_locs[m_current % kWindow]; }
+    inline auto peek_line_start() -> bool { return fill(), m_flags[m_current % kWindow] & kLineStart; }
+    inline auto peek_value() -> TokenValue { return fill(), m_values[m_current % kWindow]; }
+    inline auto peek_constant() -> Constant { return fill(), m_values[m_current % kWindow].constant; }
+    inline auto peek_symbol() -> Symbol { return fill(), m_values[m_current % kWindow].symbol; }
+    inline auto peek_literal() -> Literal { return fill(), m_values[m_current % kWindow].literal; }
+    inline auto next() -> void { ++m_current; }
+    inline auto take() -> Token {
+        auto token = peek();
+        ++m_current;
+        return token;
+    }
     inline auto location() -> size_t { return m_current; }
-    inline auto detect(TokenKind kind) -> bool { return m_tokens[m_current].kind == kind; }
+    inline auto detect(TokenKind kind) -> bool { return peek_kind() == kind; }
 
+    auto reset(size_t loc) -> void;
     auto match(TokenKind) -> bool;
     auto match(TokenKind, std::string &) -> bool;
+    auto match(TokenKind, std::string_view &) -> bool;
+    auto match(TokenKind, Symbol &) -> bool;
+    auto match(TokenKind, Literal &) -> bool;
     auto expect(TokenKind, const std::string &) -> void;
 
-    auto begin() -> decltype(auto) { return m_tokens.begin(); }
-    auto end() -> decltype(auto) { return m_tokens.end(); }
+    /// moves the next token, with its value, to `tokens`
+    auto take(TokenBuffer &tokens) -> void;
+    /// pulls the remaining tokens, up to but excluding `Eof`
+    auto collect() -> TokenBuffer;
 
     template <typename Pred>
     auto match(Pred pred) -> bool {
-        bool result = m_current < m_tokens.size() && pred(peek());
+        bool result = *this && pred(peek());
         if (result) ++m_current;
         return result;
     }
 
 private:
-    std::vector<Token> m_tokens;
-    size_t m_current;
+    inline auto fill() -> void {
+        if (m_current >= m_end) pull();
+    }
+    auto pull() -> void;
+
+    std::unique_ptr<TokenSource> m_source;
+    std::array<TokenKind, kWindow> m_kinds;
+    std::array<uint32_t, kWindow> m_lengths;
+    std::array<uint8_t, kWindow> m_flags;
+    std::array<SrcLoc, kWindow> m_locs;
+    std::array<TokenValue, kWindow> m_values;  // set for tokens that `has_value()` only
+    size_t m_current;  // index of the next token since the start of the stream
+    size_t m_end;      // tokens pulled so far, `[m_end - kWindow, m_end)` are kept
 };
 
 }  // namespace mcc
\ No newline at end of file
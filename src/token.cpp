@@ -15,10 +15,32 @@ extern auto to_string(TokenKind kind) -> std::string_view {
     return "invalid";
 }
 
+static auto spelling(TokenKind kind) -> std::string_view {
+    switch (kind) {
+#define MCC_DEFINE_KEYWORD(ENUM, STRING, VALUE) \
+    case TokenKind::ENUM: return STRING;
+#define MCC_DEFINE_PUNCTUATOR(ENUM, STRING, VALUE) \
+    case TokenKind::ENUM: return STRING;
+#include "inl/keyword.inl"
+#include "inl/punctuator.inl"
+#undef MCC_DEFINE_KEYWORD
+#undef MCC_DEFINE_PUNCTUATOR
+        default: return {};
+    }
+}
+
+auto Token::string() const -> std::string_view {
+    if (!has_source_text(kind)) return spelling(kind);
+
+    const auto text = SourceManager::instance().text(loc, length);
+    if (kind == TokenKind::Str || kind == TokenKind::Char) return text.size() >= 2 ? text.substr(1, text.size() - 2) : text;
+    return text;
+}
+
 extern auto operator<<(std::ostream &os, const Token &token) -> std::ostream & {
     os << '<' << to_string(token.kind);
-    if (!token.string.empty()) {
-        os << ':' << token.string;
+    if (!token.string().empty()) {
+        os << ':' << token.string();
     }
     return os << '>';
 }
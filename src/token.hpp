@@ -2,9 +2,12 @@
 
 #include <cstdint>
 #include <iosfwd>
-#include <string>
+#include <string_view>
+#include <type_traits>
 
+#include "literal.hpp"
 #include "srcstream.hpp"
+#include "symbol.hpp"
 
 namespace mcc {
 
@@ -17,7 +20,6 @@ enum class TokenKind {
     Char,
     Const,
     Ident,
-    Line,
 
     __MASK_PUNCT__   = 0x01000000,
     __MASK_KEYWORD__ = 0x02000000,
@@ -30,23 +32,83 @@ enum class TokenKind {
 #undef MCC_DEFINE_PUNCTUATOR
 };
 
+/// TokenFlags
+/// ----------------------------------------------------------------------------
+enum TokenFlags : uint8_t {
+    kLineStart = 1 << 0,  // first token on its line, as directives need
+};
+
 /// Token
 /// ----------------------------------------------------------------------------
+/// 16 bytes and trivially copyable, the text stays in the source buffer.
+/// `string()` is the spelling of keywords and punctuators, the source text of
+/// identifiers and constants, and the text between the quotes of string and
+/// character literals. Once the window of a streamed source moved on, only
+/// constants still have their text, identifiers and literals have a value.
 struct Token {
-    Token(TokenKind k, std::string s, SrcLoc l) : kind(k), string(s), loc(l) {}
-    Token(TokenKind k, const char *s, SrcLoc l) : kind(k), string(s), loc(l) {}
-    Token(TokenKind k, std::string_view s, SrcLoc l) : kind(k), string(s), loc(l) {}
-    ~Token() = default;
+    static constexpr uint32_t kMaxLength = (uint32_t(1) << 24) - 1;
+
     TokenKind kind;
-    std::string string;
+    uint32_t length : 24;  // of the lexeme in the source, including quotes
+    uint32_t flags : 8;    // `TokenFlags`
     SrcLoc loc;
+
+    inline auto line_start() const -> bool { return flags & kLineStart; }
+    auto string() const -> std::string_view;
+};
+
+static_assert(sizeof(Token) == 16 && std::is_trivially_copyable_v<Token>);
+
+/// ConstantType
+/// ----------------------------------------------------------------------------
+/// Type of a constant as picked by the C rules for its suffix and value, for
+/// a target with 32-bit `int` and 64-bit `long`.
+enum class ConstantType : uint8_t {
+    Int,
+    UnsignedInt,
+    Long,
+    UnsignedLong,
+    LongLong,
+    UnsignedLongLong,
+    Float,
+    Double,
+    LongDouble,
 };
 
+/// Constant
+/// ----------------------------------------------------------------------------
+/// Value of a `Const` token, decoded once by the lexer. Integers keep their
+/// 64-bit pattern, floating constants of any type a `double`.
+struct Constant {
+    ConstantType type = ConstantType::Int;
+    union {
+        uint64_t integer = 0;
+        double floating;
+    };
+
+    inline auto is_floating() const -> bool { return type >= ConstantType::Float; }
+};
+
+/// TokenValue
+/// ----------------------------------------------------------------------------
+/// What the lexer works out of a token besides its kind and place, the value
+/// of a `Const`, the symbol of an `Ident` and the decoded bytes of a `Str` or
+/// a `Char`.
+struct TokenValue {
+    Constant constant;
+    Symbol symbol;
+    Literal literal;
+};
+
+static constexpr bool is_literal(TokenKind t) { return t == TokenKind::Str || t == TokenKind::Char; }
+static constexpr bool has_value(TokenKind t) { return t == TokenKind::Const || t == TokenKind::Ident || is_literal(t); }
+
 /// TokenKind : functions
 static constexpr bool is_punct(TokenKind t) { return static_cast<uint32_t>(t) & static_cast<uint32_t>(TokenKind::__MASK_PUNCT__); }
 static constexpr bool is_punct(const Token &t) { return static_cast<uint32_t>(t.kind) & static_cast<uint32_t>(TokenKind::__MASK_PUNCT__); }
 static constexpr bool is_keyword(TokenKind t) { return static_cast<uint32_t>(t) & static_cast<uint32_t>(TokenKind::__MASK_KEYWORD__); }
 static constexpr bool is_keyword(const Token &t) { return static_cast<uint32_t>(t.kind) & static_cast<uint32_t>(TokenKind::__MASK_KEYWORD__); }
+static constexpr bool has_source_text(TokenKind t) { return t == TokenKind::Ident || t == TokenKind::Const || t == TokenKind::Str || t == TokenKind::Char; }
 
 extern auto operator<<(std::ostream &, const Token &) -> std::ostream &;
 
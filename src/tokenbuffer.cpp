@@ -0,0 +1,73 @@
+#include "tokenbuffer.hpp"
+
+#include <algorithm>
+
+namespace mcc {
+
+auto TokenBuffer::reserve(size_t size) -> void {
+    m_kinds.reserve(size);
+    m_lengths.reserve(size);
+    m_flags.reserve(size);
+    m_locs.reserve(size);
+}
+
+/// drops the tokens but keeps the memory for the next ones
+auto TokenBuffer::clear() -> void {
+    m_kinds.clear();
+    m_lengths.clear();
+    m_flags.clear();
+    m_locs.clear();
+    m_constants.clear();
+    m_symbols.clear();
+    m_literals.clear();
+}
+
+/// appends the tokens of `other` from `first` on
+auto TokenBuffer::append(const TokenBuffer &other, size_t first) -> void {
+    m_kinds.insert(m_kinds.end(), other.m_kinds.begin() + first, other.m_kinds.end());
+    m_lengths.insert(m_lengths.end(), other.m_lengths.begin() + first, other.m_lengths.end());
+    m_flags.insert(m_flags.end(), other.m_flags.begin() + first, other.m_flags.end());
+    m_locs.insert(m_locs.end(), other.m_locs.begin() + first, other.m_locs.end());
+
+    const auto constants = std::count(other.m_kinds.begin(), other.m_kinds.begin() + first, TokenKind::Const);
+    const auto symbols   = std::count(other.m_kinds.begin(), other.m_kinds.begin() + first, TokenKind::Ident);
+    const auto literals  = std::count_if(other.m_kinds.begin(), other.m_kinds.begin() + first, is_literal);
+    m_constants.insert(m_constants.end(), other.m_constants.begin() + constants, other.m_constants.end());
+    m_symbols.insert(m_symbols.end(), other.m_symbols.begin() + symbols, other.m_symbols.end());
+    m_literals.insert(m_literals.end(), other.m_literals.begin() + literals, other.m_literals.end());
+}
+
+/// replaces the tokens in [first, last) by all the tokens of `other`
+auto TokenBuffer::replace(size_t first, size_t last, const TokenBuffer &other) -> void {
+    const auto splice = [](auto &column, size_t first, size_t last, const auto &other) {
+        column.erase(column.begin() + first, column.begin() + last);
+        column.insert(column.begin() + first, other.begin(), other.end());
+    };
+    const auto count = [this](size_t first, size_t last, auto pred) -> size_t {
+        return std::count_if(m_kinds.begin() + first, m_kinds.begin() + last, pred);
+    };
+    const auto is_constant = [](TokenKind kind) { return kind == TokenKind::Const; };
+    const auto is_symbol   = [](TokenKind kind) { return kind == TokenKind::Ident; };
+
+    const auto constants = count(0, first, is_constant);
+    const auto symbols   = count(0, first, is_symbol);
+    const auto literals  = count(0, first, is_literal);
+    splice(m_constants, constants, constants + count(first, last, is_constant), other.m_constants);
+    splice(m_symbols, symbols, symbols + count(first, last, is_symbol), other.m_symbols);
+    splice(m_literals, literals, literals + count(first, last, is_literal), other.m_literals);
+
+    splice(m_kinds, first, last, other.m_kinds);
+    splice(m_lengths, first, last, other.m_lengths);
+    splice(m_flags, first, last, other.m_flags);
+    splice(m_locs, first, last, other.m_locs);
+}
+
+/// moves every token to `file`, and the ones from `first` on by `delta` bytes
+auto TokenBuffer::move_to(FileID file, size_t first, int64_t delta) -> void {
+    for (size_t i = 0; i < m_locs.size(); ++i) {
+        m_locs[i].file = file;
+        if (i >= first) m_locs[i].offset = static_cast<uint32_t>(m_locs[i].offset + delta);
+    }
+}
+
+}  // namespace mcc
\ No newline at end of file
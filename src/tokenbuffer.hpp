@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+
+#include "token.hpp"
+
+namespace mcc {
+
+/// TokenDiff
+/// ----------------------------------------------------------------------------
+/// What `relex()` changed: `removed` tokens at `first` were replaced by
+/// `inserted` new ones. The tokens after them are the old ones, moved by the
+/// length the edit added or removed.
+struct TokenDiff {
+    size_t first;
+    size_t removed;
+    size_t inserted;
+};
+
+/// TokenBuffer
+/// ----------------------------------------------------------------------------
+/// Tokens stored as a struct of arrays. Lookahead on the kind, the most
+/// frequent question of the parser and the preprocessor, only touches the
+/// dense kind array. `operator[]` assembles a whole `Token` when needed.
+/// The values of the `Const` tokens, the symbols of the `Ident` tokens and
+/// the literals of the `Str` and `Char` tokens are kept apart, in order.
+class TokenBuffer {
+public:
+    TokenBuffer() = default;
+
+    inline auto size() const -> size_t { return m_kinds.size(); }
+    inline auto empty() const -> bool { return m_kinds.empty(); }
+    inline auto kind(size_t index) const -> TokenKind { return m_kinds[index]; }
+    inline auto loc(size_t index) const -> SrcLoc { return m_locs[index]; }
+    inline auto length(size_t index) const -> uint32_t { return m_lengths[index]; }
+    inline auto flags(size_t index) const -> uint8_t { return m_flags[index]; }
+    inline auto operator[](size_t index) const -> Token { return {m_kinds[index], m_lengths[index], m_flags[index], m_locs[index]}; }
+
+    inline auto constants() const -> const std::vector<Constant> & { return m_constants; }
+    inline auto symbols() const -> const std::vector<Symbol> & { return m_symbols; }
+    inline auto literals() const -> const std::vector<Literal> & { return m_literals; }
+
+    /// only the part of `value` the kind of `token` has is kept
+    inline auto push_back(const Token &token, const TokenValue &value = {}) -> void {
+        m_kinds.push_back(token.kind);
+        m_lengths.push_back(token.length);
+        m_flags.push_back(token.flags);
+        m_locs.push_back(token.loc);
+        if (token.kind == TokenKind::Const) m_constants.push_back(value.constant);
+        if (token.kind == TokenKind::Ident) m_symbols.push_back(value.symbol);
+        if (is_literal(token.kind)) m_literals.push_back(value.literal);
+    }
+
+    auto reserve(size_t size) -> void;
+    auto clear() -> void;
+    auto append(const TokenBuffer &other, size_t first = 0) -> void;
+    auto replace(size_t first, size_t last, const TokenBuffer &other) -> void;
+    auto move_to(FileID file, size_t first, int64_t delta) -> void;
+
+private:
+    std::vector<TokenKind> m_kinds;
+    std::vector<uint32_t> m_lengths;
+    std::vector<uint8_t> m_flags;
+    std::vector<SrcLoc> m_locs;
+    std::vector<Constant> m_constants;
+    std::vector<Symbol> m_symbols;
+    std::vector<Literal> m_literals;
+};
+
+}  // namespace mcc
\ No newline at end of file
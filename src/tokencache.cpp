@@ -0,0 +1,417 @@
+#include "tokencache.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#define MCC_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define MCC_HAS_MMAP 0
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#endif
+
+#ifndef MCC_VERSION
+#define MCC_VERSION "unknown"
+#endif
+
+namespace mcc {
+
+namespace detail {
+
+/// XXH64
+/// ----------------------------------------------------------------------------
+constexpr uint64_t kPrime1 = 11400714785074694791ull;
+constexpr uint64_t kPrime2 = 14029467366897019727ull;
+constexpr uint64_t kPrime3 = 1609587929392839161ull;
+constexpr uint64_t kPrime4 = 9650029242287828579ull;
+constexpr uint64_t kPrime5 = 2870177450012600261ull;
+
+static inline auto rotl(uint64_t x, int r) -> uint64_t { return x << r | x >> (64 - r); }
+
+static inline auto read64(const char *p) -> uint64_t {
+    uint64_t result;
+    std::memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+static inline auto read32(const char *p) -> uint32_t {
+    uint32_t result;
+    std::memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+static inline auto round(uint64_t acc, uint64_t input) -> uint64_t { return rotl(acc + input * kPrime2, 31) * kPrime1; }
+
+static inline auto merge(uint64_t acc, uint64_t value) -> uint64_t { return (acc ^ round(0, value)) * kPrime1 + kPrime4; }
+
+static auto xxh64(const char *data, size_t size, uint64_t seed = 0) -> uint64_t {
+    auto p          = data;
+    const auto last = data + size;
+
+    uint64_t h;
+    if (size >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2, v2 = seed + kPrime2, v3 = seed, v4 = seed - kPrime1;
+        for (; p + 32 <= last; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge(merge(merge(merge(h, v1), v2), v3), v4);
+    } else {
+        h = seed + kPrime5;
+    }
+
+    h += size;
+    for (; p + 8 <= last; p += 8) h = rotl(h ^ round(0, read64(p)), 27) * kPrime1 + kPrime4;
+    if (p + 4 <= last) h = rotl(h ^ read32(p) * kPrime1, 23) * kPrime2 + kPrime3, p += 4;
+    for (; p < last; ++p) h = rotl(h ^ static_cast<unsigned char>(*p) * kPrime5, 11) * kPrime1;
+
+    h ^= h >> 33, h *= kPrime2;
+    h ^= h >> 29, h *= kPrime3;
+    return h ^ h >> 32;
+}
+
+/// changes whenever a keyword or punctuator is added, removed or renumbered
+static constexpr auto kinds_fingerprint() -> uint64_t {
+    uint64_t result = 14695981039346656037ull;
+    const auto mix  = [&result](std::string_view spelling, uint32_t value) {
+        for (auto ch : spelling) result = (result ^ static_cast<unsigned char>(ch)) * 1099511628211ull;
+        result = (result ^ value) * 1099511628211ull;
+    };
+#define MCC_DEFINE_KEYWORD(ENUM, STRING, VALUE) mix(STRING, static_cast<uint32_t>(TokenKind::ENUM));
+#define MCC_DEFINE_PUNCTUATOR(ENUM, STRING, VALUE) mix(STRING, static_cast<uint32_t>(TokenKind::ENUM));
+#include "inl/keyword.inl"
+#include "inl/punctuator.inl"
+#undef MCC_DEFINE_KEYWORD
+#undef MCC_DEFINE_PUNCTUATOR
+    return result;
+}
+
+/// Blob
+/// ----------------------------------------------------------------------------
+/// A header followed by the sections below, each 8-byte aligned. Symbols and
+/// literals index one table of distinct strings.
+///
+///     kinds     : uint32_t[tokens]
+///     lengths   : uint32_t[tokens]
+///     offsets   : uint32_t[tokens]
+///     constants : Constant[constants]
+///     symbols   : uint32_t[symbols]
+///     literals  : uint32_t[literals]
+///     strings   : uint32_t[strings + 1], where each string starts in `text`
+///     flags     : uint8_t[tokens]
+///     text      : char[text]
+///
+constexpr uint32_t kFormat = 1;
+constexpr char kMagic[8]   = {'m', 'c', 'c', 't', 'o', 'k', 'e', 'n'};
+
+struct Header {
+    char magic[8];
+    char version[24];      // MCC_VERSION, zero padded
+    uint64_t fingerprint;  // `kFormat` and `kinds_fingerprint()`
+    uint64_t hash;         // xxHash of the source
+    uint64_t size;         // of the source
+    uint64_t checksum;     // xxHash of everything after the header
+    uint32_t tokens;
+    uint32_t constants;
+    uint32_t symbols;
+    uint32_t literals;
+    uint32_t strings;
+    uint32_t text;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(Header) % 8 == 0 && std::is_trivially_copyable_v<Constant>);
+
+struct Layout {
+    size_t kinds, lengths, offsets, constants, symbols, literals, strings, flags, text, size;
+};
+
+static auto align(size_t size) -> size_t { return (size + 7) & ~size_t(7); }
+
+static auto layout(const Header &header) -> Layout {
+    Layout result;
+    result.kinds     = sizeof(Header);
+    result.lengths   = align(result.kinds + size_t(header.tokens) * 4);
+    result.offsets   = align(result.lengths + size_t(header.tokens) * 4);
+    result.constants = align(result.offsets + size_t(header.tokens) * 4);
+    result.symbols   = align(result.constants + size_t(header.constants) * sizeof(Constant));
+    result.literals  = align(result.symbols + size_t(header.symbols) * 4);
+    result.strings   = align(result.literals + size_t(header.literals) * 4);
+    result.flags     = align(result.strings + (size_t(header.strings) + 1) * 4);
+    result.text      = align(result.flags + header.tokens);
+    result.size      = result.text + header.text;
+    return result;
+}
+
+static auto expected_header(FileID file) -> Header {
+    const auto &buffer = SourceManager::instance().buffer(file);
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    std::strncpy(header.version, MCC_VERSION, sizeof(header.version) - 1);
+    header.fingerprint = kinds_fingerprint() ^ kFormat;
+    header.hash        = xxh64(buffer.data(), buffer.size());
+    header.size        = buffer.size();
+    return header;
+}
+
+/// Cache
+/// ----------------------------------------------------------------------------
+struct Cache {
+    bool initialized = false;
+    std::string directory;  // empty if the cache is off
+};
+
+static auto cache() -> Cache & {
+    static Cache cache;
+    if (!cache.initialized) {
+        cache.initialized = true;
+        if (auto env = std::getenv("MCC_TOKEN_CACHE"); env && *env) cache.directory = env;
+    }
+    return cache;
+}
+
+static auto blob_path(uint64_t hash) -> std::string {
+    static constexpr char kHex[] = "0123456789abcdef";
+
+    std::string result = cache().directory + "/";
+    for (int shift = 60; shift >= 0; shift -= 4) result += kHex[hash >> shift & 15];
+    return result + ".tok";
+}
+
+/// reads a whole blob, mapped where possible
+class BlobFile {
+public:
+    BlobFile(const std::string &path);
+    ~BlobFile();
+    BlobFile(BlobFile &&)      = delete;
+    BlobFile(const BlobFile &) = delete;
+    auto operator=(BlobFile &&) -> BlobFile & = delete;
+    auto operator=(const BlobFile &) -> BlobFile & = delete;
+
+    inline auto data() const -> const char * { return m_data; }
+    inline auto size() const -> size_t { return m_size; }
+
+private:
+    const char *m_data;
+    size_t m_size;
+    bool m_mapped;
+    std::string m_storage;
+};
+
+BlobFile::BlobFile(const std::string &path) : m_data(nullptr), m_size(0), m_mapped(false) {
+#if MCC_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= static_cast<off_t>(sizeof(Header))) {
+        auto base = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base != MAP_FAILED) {
+            m_data   = static_cast<const char *>(base);
+            m_size   = static_cast<size_t>(st.st_size);
+            m_mapped = true;
+        }
+    }
+    ::close(fd);
+#else
+    std::ifstream stream(path, std::ios::binary);
+    m_storage.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    if (m_storage.size() >= sizeof(Header)) m_data = m_storage.data(), m_size = m_storage.size();
+#endif
+}
+
+BlobFile::~BlobFile() {
+#if MCC_HAS_MMAP
+    if (m_mapped) ::munmap(const_cast<char *>(m_data), m_size);
+#endif
+}
+
+/// checks the blob against `expected`, its checksum and that every index is
+/// in bounds, so a truncated or corrupt file is only a miss.
+static auto validate(const BlobFile &blob, const Header &expected, Header &header) -> bool {
+    if (blob.data() == nullptr) return false;
+    std::memcpy(&header, blob.data(), sizeof(Header));
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) return false;
+    if (std::memcmp(header.version, expected.version, sizeof(header.version)) != 0) return false;
+    if (header.fingerprint != expected.fingerprint || header.hash != expected.hash || header.size != expected.size) return false;
+    if (layout(header).size != blob.size()) return false;
+    if (xxh64(blob.data() + sizeof(Header), blob.size() - sizeof(Header)) != header.checksum) return false;
+
+    const auto at = layout(header);
+    auto strings  = reinterpret_cast<const uint32_t *>(blob.data() + at.strings);
+    if (strings[0] != 0 || strings[header.strings] != header.text) return false;
+    for (uint32_t i = 0; i < header.strings; ++i) {
+        if (strings[i] > strings[i + 1]) return false;
+    }
+
+    const auto symbols  = reinterpret_cast<const uint32_t *>(blob.data() + at.symbols);
+    const auto literals = reinterpret_cast<const uint32_t *>(blob.data() + at.literals);
+    const auto in_range = [&header](uint32_t index) { return index < header.strings; };
+    return std::all_of(symbols, symbols + header.symbols, in_range) && std::all_of(literals, literals + header.literals, in_range);
+}
+
+template <typename T>
+static auto append(std::string &blob, size_t at, const T *data, size_t count) -> void {
+    blob.resize(at, '\0');
+    blob.append(reinterpret_cast<const char *>(data), count * sizeof(T));
+}
+
+}  // namespace detail
+
+extern auto set_token_cache(std::string directory) -> void {
+    auto &cache       = detail::cache();
+    cache.directory   = std::move(directory);
+    cache.initialized = true;
+}
+
+extern auto token_cache_enabled() -> bool { return !detail::cache().directory.empty(); }
+
+extern auto load_tokens(FileID file, TokenBuffer &tokens) -> bool {
+    if (!token_cache_enabled()) return false;
+
+    const auto expected = detail::expected_header(file);
+    const detail::BlobFile blob(detail::blob_path(expected.hash));
+
+    detail::Header header;
+    if (!detail::validate(blob, expected, header)) return false;
+
+    const auto at       = detail::layout(header);
+    const auto data     = blob.data();
+    const auto kinds    = reinterpret_cast<const TokenKind *>(data + at.kinds);
+    const auto lengths  = reinterpret_cast<const uint32_t *>(data + at.lengths);
+    const auto offsets  = reinterpret_cast<const uint32_t *>(data + at.offsets);
+    const auto consts   = reinterpret_cast<const Constant *>(data + at.constants);
+    const auto symbols  = reinterpret_cast<const uint32_t *>(data + at.symbols);
+    const auto literals = reinterpret_cast<const uint32_t *>(data + at.literals);
+    const auto strings  = reinterpret_cast<const uint32_t *>(data + at.strings);
+    const auto flags    = reinterpret_cast<const uint8_t *>(data + at.flags);
+    const auto text     = data + at.text;
+
+    // every distinct string is interned once, as whatever it is used for
+    const auto string = [&](uint32_t index) { return std::string_view(text + strings[index], strings[index + 1] - strings[index]); };
+    std::vector<Symbol> interned_symbols(header.strings);
+    std::vector<Literal> interned_literals(header.strings);
+    for (uint32_t i = 0; i < header.symbols; ++i) {
+        if (interned_symbols[symbols[i]].empty()) interned_symbols[symbols[i]] = Symbol::intern(string(symbols[i]));
+    }
+    for (uint32_t i = 0; i < header.literals; ++i) interned_literals[literals[i]] = Literal::intern(string(literals[i]));
+
+    TokenBuffer result;
+    result.reserve(header.tokens);
+    uint32_t constant = 0, symbol = 0, literal = 0;
+    for (uint32_t i = 0; i < header.tokens; ++i) {
+        const Token token{kinds[i], lengths[i], flags[i], {file, offsets[i]}};
+        if (token.length > Token::kMaxLength || offsets[i] > header.size) return false;
+
+        TokenValue value;
+        if (token.kind == TokenKind::Const && constant < header.constants) value.constant = consts[constant++];
+        else if (token.kind == TokenKind::Ident && symbol < header.symbols) value.symbol = interned_symbols[symbols[symbol++]];
+        else if (is_literal(token.kind) && literal < header.literals) value.literal = interned_literals[literals[literal++]];
+        else if (has_value(token.kind)) return false;
+        result.push_back(token, value);
+    }
+    if (constant != header.constants || symbol != header.symbols || literal != header.literals) return false;
+
+    tokens = std::move(result);
+    return true;
+}
+
+extern auto store_tokens(FileID file, const TokenBuffer &tokens) -> void {
+    if (!token_cache_enabled()) return;
+
+    auto header = detail::expected_header(file);
+
+    std::vector<TokenKind> kinds(tokens.size());
+    std::vector<uint32_t> lengths(tokens.size()), offsets(tokens.size());
+    std::vector<uint8_t> flags(tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        kinds[i]   = tokens.kind(i);
+        lengths[i] = tokens.length(i);
+        offsets[i] = tokens.loc(i).offset;
+        flags[i]   = tokens.flags(i);
+    }
+
+    std::string text;
+    std::vector<uint32_t> strings{0};
+    std::unordered_map<std::string, uint32_t> indices;
+    const auto index = [&](std::string_view string) {
+        auto [iter, added] = indices.emplace(string, static_cast<uint32_t>(strings.size() - 1));
+        if (added) {
+            text.append(string);
+            strings.push_back(static_cast<uint32_t>(text.size()));
+        }
+        return iter->second;
+    };
+
+    std::vector<uint32_t> symbols, literals;
+    for (auto symbol : tokens.symbols()) symbols.push_back(index(symbol.string()));
+    for (auto literal : tokens.literals()) literals.push_back(index(literal.string()));
+
+    header.tokens    = static_cast<uint32_t>(tokens.size());
+    header.constants = static_cast<uint32_t>(tokens.constants().size());
+    header.symbols   = static_cast<uint32_t>(symbols.size());
+    header.literals  = static_cast<uint32_t>(literals.size());
+    header.strings   = static_cast<uint32_t>(strings.size() - 1);
+    header.text      = static_cast<uint32_t>(text.size());
+
+    const auto at = detail::layout(header);
+    std::string blob;
+    blob.reserve(at.size);
+    detail::append(blob, 0, &header, 1);
+    detail::append(blob, at.kinds, kinds.data(), kinds.size());
+    detail::append(blob, at.lengths, lengths.data(), lengths.size());
+    detail::append(blob, at.offsets, offsets.data(), offsets.size());
+    detail::append(blob, at.constants, tokens.constants().data(), tokens.constants().size());
+    detail::append(blob, at.symbols, symbols.data(), symbols.size());
+    detail::append(blob, at.literals, literals.data(), literals.size());
+    detail::append(blob, at.strings, strings.data(), strings.size());
+    detail::append(blob, at.flags, flags.data(), flags.size());
+    detail::append(blob, at.text, text.data(), text.size());
+
+    header.checksum = detail::xxh64(blob.data() + sizeof(header), blob.size() - sizeof(header));
+    std::memcpy(blob.data(), &header, sizeof(header));
+
+    // written aside and renamed, so a concurrent run never maps half a blob
+    const auto path = detail::blob_path(header.hash);
+#if MCC_HAS_MMAP
+    ::mkdir(detail::cache().directory.c_str(), 0777);
+    const auto temp = path + "." + std::to_string(::getpid());
+    int fd          = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) return;
+
+    size_t done = 0;
+    while (done < blob.size()) {
+        auto count = ::write(fd, blob.data() + done, blob.size() - done);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break;
+        done += count;
+    }
+    ::close(fd);
+
+    if (done != blob.size() || ::rename(temp.c_str(), path.c_str()) != 0) ::unlink(temp.c_str());
+#else
+    const auto temp = path + ".tmp";
+    {
+        std::ofstream stream(temp, std::ios::binary);
+        if (!stream.write(blob.data(), blob.size())) return;
+    }
+    std::remove(path.c_str());
+    std::rename(temp.c_str(), path.c_str());
+#endif
+}
+
+}  // namespace mcc
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+#include "tokenbuffer.hpp"
+
+namespace mcc {
+
+/// Token cache
+/// ----------------------------------------------------------------------------
+/// An optional on-disk cache of lexed files, so that unchanged files are not
+/// lexed again on the next run. The tokens of a file are stored in one flat
+/// blob named after a 64-bit xxHash of its contents. The blob also records
+/// the mcc version and a fingerprint of `TokenKind`, so an edited file or a
+/// different build never reads stale tokens. Symbols and literals are stored
+/// by their text and interned again on load.
+///
+/// The cache is off unless a directory is set with `set_token_cache()`, or
+/// with the `MCC_TOKEN_CACHE` environment variable.
+extern auto set_token_cache(std::string directory) -> void;
+extern auto token_cache_enabled() -> bool;
+
+/// all the tokens of `file` from the cache, false if there are none
+extern auto load_tokens(FileID file, TokenBuffer &tokens) -> bool;
+
+/// stores all the tokens of `file`. Best effort, failures are ignored.
+extern auto store_tokens(FileID file, const TokenBuffer &tokens) -> void;
+
+}  // namespace mcc
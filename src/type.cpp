@@ -136,10 +136,10 @@ auto PointerType::format(const std::string &id) -> std::string {
 auto FunctionType::format(const std::string &id) -> std::string {
     std::string result = m_rettype.format(id) + '(';
     if (!m_param_types.empty()) {
-        result += m_param_types.front().format(m_param_names.front());
+        result += m_param_types.front().format(std::string(m_param_names.front().string()));
         for (size_t i = 1; i < m_param_types.size(); ++i) {
             result += ", ";
-            result += m_param_types[i].format(m_param_names[i]);
+            result += m_param_types[i].format(std::string(m_param_names[i].string()));
         }
     }
     if (m_variadic) result += ", ...";
@@ -206,7 +206,7 @@ class FunctionType : public IType {
     MCC_DEFINE_MEMBER(bool, variadic)
     MCC_DEFINE_MEMBER(QualType, rettype)
     MCC_DEFINE_MEMBER(std::vector<QualType>, param_types)
-    MCC_DEFINE_MEMBER(std::vector<std::string>, param_names)
+    MCC_DEFINE_MEMBER(std::vector<Symbol>, param_names)
 
     FunctionType(const QualType& ret) : m_variadic(false), m_rettype(ret) {}
     static auto make(QualType ret) -> Pointer;
@@ -0,0 +1,47 @@
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+#include "asttypes.hpp"
+#include "test.hpp"
+
+/// Allocations
+/// ----------------------------------------------------------------------------
+/// Counts every `operator new` of the whole pipeline on test/10k.c. Sources
+/// and tokens are never copied between the stages, so lexing allocates a
+/// bounded number of times whatever the size, even the first time, when the
+/// symbols and literals are new, and parsing about once per AST node.
+static size_t allocations = 0;
+
+auto operator new(size_t size) -> void * {
+    ++allocations;
+    if (auto result = std::malloc(size ? size : 1)) return result;
+    throw std::bad_alloc();
+}
+auto operator delete(void *pointer) noexcept -> void { std::free(pointer); }
+auto operator delete(void *pointer, size_t) noexcept -> void { std::free(pointer); }
+
+auto main() -> int {
+    static_assert(!std::is_copy_constructible_v<mcc::SrcStream> && std::is_move_constructible_v<mcc::SrcStream>);
+    static_assert(!std::is_copy_constructible_v<mcc::TkStream> && std::is_move_constructible_v<mcc::TkStream>);
+
+    const auto file = mcc::SourceManager::instance().load("test/10k.c");
+
+    // the first lex of the process interns every symbol and literal
+    const auto before = allocations;
+    auto ts           = mcc::lex(mcc::SrcStream(file));
+    size_t tokens     = 0;
+    for (; ts; ++tokens) ts.next();
+    const auto lexing = allocations - before;
+
+    // the streams are moved from stage to stage, never copied
+    const auto start   = allocations;
+    auto program       = mcc::parse(mcc::preprocess(mcc::lex(mcc::SrcStream(file))));
+    const auto parsing = allocations - start;
+
+    std::printf("%zu tokens, %zu allocations lexing, %zu for the pipeline\n", tokens, lexing, parsing);
+    CHECK(tokens > 100000);
+    CHECK(lexing < 64);
+    CHECK(parsing < tokens);
+    return test::done();
+}
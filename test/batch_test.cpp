@@ -0,0 +1,136 @@
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "test.hpp"
+
+/// Batch lexing
+/// ----------------------------------------------------------------------------
+/// `lex_batch()` has to give each snippet the tokens `lex()` gives it alone,
+/// leave the error of a snippet that does not lex in its range, and reuse
+/// its memory once the arenas have grown.
+static std::atomic<size_t> allocations{0};
+
+auto operator new(size_t size) -> void * {
+    ++allocations;
+    if (auto result = std::malloc(size ? size : 1)) return result;
+    throw std::bad_alloc();
+}
+auto operator delete(void *pointer) noexcept -> void { std::free(pointer); }
+auto operator delete(void *pointer, size_t) noexcept -> void { std::free(pointer); }
+
+/// the tokens of `range` as a buffer of their own
+static auto slice(const mcc::TokenBuffer &tokens, const mcc::TokenRange &range) -> mcc::TokenBuffer {
+    mcc::TokenBuffer result;
+    auto constant = range.constants, symbol = range.symbols, literal = range.literals;
+    for (auto i = range.first; i < range.first + range.size; ++i) {
+        mcc::TokenValue value;
+        if (tokens.kind(i) == mcc::TokenKind::Const) value.constant = tokens.constants()[constant++];
+        if (tokens.kind(i) == mcc::TokenKind::Ident) value.symbol = tokens.symbols()[symbol++];
+        if (mcc::is_literal(tokens.kind(i))) value.literal = tokens.literals()[literal++];
+        result.push_back(tokens[i], value);
+    }
+    return result;
+}
+
+auto main() -> int {
+    const std::vector<std::string_view> kSnippets = {
+        "int x = 1;",
+        "  a->b[3] += f(\"s\\n\", 'c', 0x1fu);",
+        "/* c */ for (i = 0; i < n; ++i) sum += v[i];",
+        "",
+        "# define X 2\nX",
+        "return 1.5e3 + y; // tail",
+        "\xef\xbb\xbf" "char *s = \"\xc3\xa9\";",
+    };
+
+    auto &sm        = mcc::SourceManager::instance();
+    const auto file = sm.add("<batch>", "");
+    auto context    = std::make_unique<mcc::LexContext>(file);
+
+    mcc::lex_batch(*context, kSnippets);
+    CHECK(context->ranges().size() == kSnippets.size());
+    for (size_t i = 0; i < kSnippets.size(); ++i) {
+        const auto alone = mcc::lex(kSnippets[i], "<snippet>").collect();
+        CHECK(test::same(slice(context->tokens(), context->ranges()[i]), alone));
+    }
+
+    // a snippet that does not lex ends in its error, the others lex as usual
+    struct Bad {
+        std::string_view text;
+        const char *message;
+    };
+    const Bad kBad[] = {
+        {"s = \"abc", "expect literal terminator."},
+        {"s = \"abc\\", "expect literal terminator."},
+        {"a /* b", "expect comment terminator `*/`."},
+        {"a @ b", "unknown punctuator."},
+        {"x = 0x;", "invalid constant."},
+        {"s = \"\\q\";", "invalid escape sequence."},
+        {"a \xff b", "invalid UTF-8 sequence."},
+        {"a = b; \xc3", "invalid UTF-8 sequence."},
+        {std::string_view("a = \0 b;", 9), "null character in snippet."},
+    };
+    std::vector<std::string_view> mixed;
+    for (const auto &bad : kBad) {
+        mixed.push_back(bad.text);
+        mixed.push_back("int y = 2;");
+    }
+    mcc::lex_batch(*context, mixed);
+    for (size_t i = 0; i < std::size(kBad); ++i) {
+        const auto &range = context->ranges()[2 * i];
+        const auto error  = context->tokens()[range.first + range.size - 1];
+        CHECK(range.size > 0 && error.kind == mcc::TokenKind::None);
+        CHECK(std::string_view(mcc::lex_error_message(error)) == kBad[i].message);
+        CHECK(context->ranges()[2 * i + 1].size == 5);
+        CHECK(error.loc.offset < context->tokens().loc(context->ranges()[2 * i + 1].first).offset);
+    }
+
+    // an escaped separator does not run into the next snippet, or past the
+    // arena after the last one
+    mcc::lex_batch(*context, {"int y = 2;", "s = \"abc\\"});
+    const auto &last = context->ranges().back();
+    CHECK(context->ranges().size() == 2 && context->ranges().front().size == 5);
+    CHECK(last.size == 3 && context->tokens().kind(last.first + 2) == mcc::TokenKind::None);
+
+    // nothing is allocated once the arenas fit the largest batch
+    std::vector<std::string_view> many;
+    for (size_t i = 0; i < 1000; ++i) many.push_back(kSnippets[i % kSnippets.size()]);
+    mcc::lex_batch(*context, many);
+    const auto before = allocations.load();
+    for (int i = 0; i < 10; ++i) mcc::lex_batch(*context, many);
+    CHECK(allocations == before);
+    CHECK(context->ranges().size() == many.size());
+
+    // the context releases its source, the next one gets the same entry
+    context.reset();
+    CHECK(sm.add("<batch>", "") == file);
+
+    // contexts made, used and destroyed on several threads, while another
+    // one adds sources
+    std::vector<mcc::TokenBuffer> expected;
+    for (auto snippet : kSnippets) expected.push_back(mcc::lex(snippet, "<snippet>").collect());
+
+    std::vector<char> agreed(8, true);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < agreed.size(); ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < 50; ++i) {
+                mcc::LexContext context(sm.add("<worker>", ""));
+                mcc::lex_batch(context, kSnippets);
+                for (size_t k = 0; k < kSnippets.size(); ++k) {
+                    if (!test::same(slice(context.tokens(), context.ranges()[k]), expected[k])) agreed[t] = false;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 2000; ++i) sm.add("<other>", "int x;");
+    for (auto &worker : workers) worker.join();
+    for (auto ok : agreed) CHECK(ok);
+    return test::done();
+}
@@ -0,0 +1,86 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "test.hpp"
+#include "tokencache.hpp"
+
+/// Token cache
+/// ----------------------------------------------------------------------------
+/// Tokens loaded from the cache have to be the ones `lex()` gives, for any
+/// source with the same bytes and for no other, and a damaged blob has to be
+/// a miss that `lex()` falls back from.
+static auto same_places(const mcc::TokenBuffer &a, const mcc::TokenBuffer &b, mcc::FileID file) -> bool {
+    if (!test::same(a, b)) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a.loc(i).offset != b.loc(i).offset || a.loc(i).file != file) return false;
+    }
+    return true;
+}
+
+/// the only blob in `directory`
+static auto blob(const std::filesystem::path &directory) -> std::filesystem::path {
+    std::filesystem::path result;
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() == ".tok") result = entry.path();
+    }
+    return result;
+}
+
+auto main() -> int {
+    auto &sm = mcc::SourceManager::instance();
+
+    // lexed before the cache is on
+    const auto file     = sm.load("test/10k.c");
+    const auto expected = test::lex_file(file);
+
+    char temp[] = "/tmp/mcc-cache-XXXXXX";
+    if (!::mkdtemp(temp)) return std::printf("can not create a directory\n"), 1;
+    const std::filesystem::path directory = temp;
+    mcc::set_token_cache(directory.string());
+    CHECK(mcc::token_cache_enabled());
+
+    mcc::TokenBuffer tokens;
+    CHECK(!mcc::load_tokens(file, tokens));
+    mcc::store_tokens(file, expected);
+    CHECK(mcc::load_tokens(file, tokens) && same_places(tokens, expected, file));
+    CHECK(same_places(mcc::lex(mcc::SrcStream(file)).collect(), expected, file));
+
+    // keyed on the bytes, not the name
+    std::ifstream stream("test/10k.c", std::ios::binary);
+    const std::string source((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    const auto copy = sm.add("<copy>", source);
+    CHECK(mcc::load_tokens(copy, tokens) && same_places(tokens, expected, copy));
+
+    auto edited      = source;
+    edited.back()    = edited.back() == ' ' ? '\t' : ' ';
+    const auto other = sm.add("<edited>", edited);
+    CHECK(!mcc::load_tokens(other, tokens));
+
+    // a flipped byte and a truncated blob are misses, `lex()` lexes and
+    // stores the tokens again
+    const auto path = blob(directory);
+    CHECK(!path.empty());
+    const auto size = std::filesystem::file_size(path);
+    {
+        std::fstream damaged(path, std::ios::in | std::ios::out | std::ios::binary);
+        damaged.seekg(size / 2);
+        const auto byte = static_cast<char>(damaged.get());
+        damaged.seekp(size / 2);
+        damaged.put(static_cast<char>(byte ^ 1));
+    }
+    CHECK(!mcc::load_tokens(file, tokens));
+    CHECK(same_places(mcc::lex(mcc::SrcStream(file)).collect(), expected, file));
+    CHECK(mcc::load_tokens(file, tokens) && same_places(tokens, expected, file));
+
+    std::filesystem::resize_file(path, size - 8);
+    CHECK(!mcc::load_tokens(file, tokens));
+    std::filesystem::resize_file(path, 16);
+    CHECK(!mcc::load_tokens(file, tokens));
+    CHECK(same_places(mcc::lex(mcc::SrcStream(file)).collect(), expected, file));
+    CHECK(std::filesystem::file_size(path) == size);
+
+    std::filesystem::remove_all(directory);
+    return test::done();
+}
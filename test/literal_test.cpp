@@ -0,0 +1,76 @@
+#include <sstream>
+#include <string>
+
+#include "astformatter.hpp"
+#include "astjsonwriter.hpp"
+#include "asttypes.hpp"
+#include "simd.hpp"
+#include "test.hpp"
+
+/// Literals
+/// ----------------------------------------------------------------------------
+/// The bytes of a literal never move once interned. Valid UTF-8 is written
+/// as it is and every other byte escapes to printable ASCII that decodes
+/// back to it, so formatted output lexes to the same literals whatever bytes
+/// they hold.
+static auto printable(std::string_view text) -> bool {
+    bool ascii;
+    for (auto ch : text) {
+        if ((ch >= 0 && ch < 0x20) || ch == 0x7f) return false;
+    }
+    return mcc::simd::validate_utf8(text.data(), text.size(), ascii) == text.size();
+}
+
+static auto round_trip(std::string_view bytes, char quote) -> bool {
+    std::string decoded;
+    const auto escaped = mcc::escape_literal(bytes, quote);
+    return printable(escaped) && mcc::decode_literal(escaped, decoded) && decoded == bytes;
+}
+
+auto main() -> int {
+    // views stay where they are while the pool grows, past a block and with
+    // bytes longer than one
+    const auto first = mcc::Literal::intern("first");
+    const auto view  = first.string();
+    for (int i = 0; i < 20000; ++i) mcc::Literal::intern("literal " + std::to_string(i));
+    const auto large = mcc::Literal::intern(std::string(100000, 'x'));
+    CHECK(first.string().data() == view.data());
+    CHECK(view == "first");
+    CHECK(large.string() == std::string(100000, 'x'));
+    CHECK(mcc::Literal::intern("first") == first);
+    CHECK(mcc::Literal::intern("literal 1234").string() == "literal 1234");
+    CHECK(mcc::Literal::intern("").empty());
+
+    // every byte, alone and before digits and letters that could extend an
+    // escape
+    for (int byte = 0; byte < 256; ++byte) {
+        for (auto next : {"", "0", "7", "8", "a", "f", "g", "F"}) {
+            const auto bytes = std::string(1, static_cast<char>(byte)) + next;
+            CHECK(round_trip(bytes, '\"'));
+            CHECK(round_trip(bytes, '\''));
+        }
+    }
+    CHECK(mcc::escape_literal("\xff", '\"') == "\\xff");
+    CHECK(mcc::escape_literal("\xff" "f", '\"') == "\\xff\\146");
+    CHECK(mcc::escape_literal("\xc3\xa9t\xe2\x82\xac", '\"') == "\xc3\xa9t\xe2\x82\xac");
+    CHECK(mcc::escape_literal("\xc3\xa9\xc3", '\"') == "\xc3\xa9\\xc3");
+    CHECK(mcc::escape_literal("\xc2\x85", '\"') == "\\xc2\\x85");
+
+    const std::string source = "char *s = \"\\xff\" \"caf\\u00e9\\x80\";\nint c = '\\xfe';\n";
+    auto program             = mcc::parse(mcc::preprocess(mcc::lex(source, "<literals>")));
+
+    std::ostringstream formatted;
+    auto formatter = mcc::AstFormatter(formatted);
+    program.accept(formatter);
+    const auto tokens = mcc::lex(formatted.str(), "<formatted>").collect();
+    CHECK(formatted.str().find("\"\\xff\\143af\xc3\xa9\\x80\"") != std::string::npos);
+    CHECK(tokens.literals().size() == 2);
+    CHECK(tokens.literals().front() == mcc::Literal::intern("\xff" "caf\xc3\xa9\x80"));
+    CHECK(tokens.literals().back() == mcc::Literal::intern("\xfe"));
+
+    std::ostringstream json;
+    auto writer = mcc::AstJsonWriter(json);
+    program.accept(writer);
+    CHECK(json.str().find("\"\\u00ffcaf\xc3\xa9\\u0080\"") != std::string::npos);
+    return test::done();
+}
@@ -0,0 +1,70 @@
+#include <random>
+#include <string>
+
+#include "test.hpp"
+
+/// Parallel lexing
+/// ----------------------------------------------------------------------------
+/// `lex_parallel()` has to give the tokens `lex()` gives, at the same places,
+/// for any number of threads, also where a chunk starts inside a comment or
+/// a literal and its guess is wrong.
+static auto same_places(const mcc::TokenBuffer &a, const mcc::TokenBuffer &b) -> bool {
+    if (!test::same(a, b)) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a.loc(i).offset != b.loc(i).offset) return false;
+    }
+    return true;
+}
+
+/// about `size` bytes of declarations, with comments longer than a chunk and
+/// comments and literals that hold what looks like the start or the end of
+/// one
+static auto generate(size_t size) -> std::string {
+    static const char *const kLines[] = {
+        "int value = 42 + 'c' * 7;\n",
+        "char *open = \"/* not a comment\";\n",
+        "char *close = \"*/ not the end of one\";\n",
+        "char slash = '/', star = '*';\n",
+        "// */ int trap = 1; /*\n",
+        "double ratio = 1.5e3 / 2; /* short */ long count = 0L;\n",
+        "/* a /* does not nest\n   int hidden; */ int shown;\n",
+    };
+    static const char *const kComment[] = {
+        "  text with \"quotes\" and 'apostrophes'\n",
+        "  a /* inside a comment\n",
+        "  // and a line comment\n",
+        "  int not_code = 0;\n",
+    };
+
+    std::mt19937 rng(16);
+    std::string source;
+    for (size_t i = 0; source.size() < size; ++i) {
+        if (rng() % 4096 == 0) {
+            // up to two chunks of comment, cut anywhere by chunk boundaries
+            source += "/*";
+            const auto end = source.size() + (size_t(rng() % 512) << 10);
+            while (source.size() < end) source += kComment[rng() % std::size(kComment)];
+            source += "*/\n";
+        } else {
+            source += "int v" + std::to_string(i) + " = " + std::to_string(rng() % 1000) + ";\n";
+            source += kLines[rng() % std::size(kLines)];
+        }
+    }
+    return source;
+}
+
+auto main() -> int {
+    auto &sm = mcc::SourceManager::instance();
+
+    const auto file     = sm.load("test/10k.c");
+    const auto expected = test::lex_file(file);
+    for (size_t threads : {1, 2, 4, 8}) CHECK(same_places(mcc::lex_parallel(file, threads), expected));
+
+    // below the size `lex()` hands to the parallel lexer, in a dozen chunks
+    const auto source    = generate(size_t(3) << 20);
+    const auto generated = sm.add("<generated>", source);
+    const auto tokens    = test::lex_file(generated);
+    CHECK(tokens.size() > 100000);
+    for (size_t threads : {1, 2, 4, 8}) CHECK(same_places(mcc::lex_parallel(generated, threads), tokens));
+    return test::done();
+}
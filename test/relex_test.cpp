@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "test.hpp"
+
+/// Incremental lexing
+/// ----------------------------------------------------------------------------
+/// Random edits of test/10k.c, each re-lexed with `relex()` and compared with
+/// lexing the edited source from scratch. The edits insert whole tokens after
+/// a blank or swap one blank for another, so the source keeps lexing. Then
+/// edits that do not lex have to leave an error token instead of exiting.
+
+/// line and column of `offset`, counted in `text`
+static auto where(const std::string &text, uint32_t offset) -> std::pair<size_t, size_t> {
+    const auto line = text.rfind('\n', offset == 0 ? std::string::npos : offset - 1);
+    const auto first = offset == 0 || line == std::string::npos ? 0 : line + 1;
+    return {std::count(text.begin(), text.begin() + offset, '\n') + 1, offset - first + 1};
+}
+
+auto main() -> int {
+    static const char *kInserts[] = {"x ", " ", "1 ", "+ ", "int y; ", "/* c */ ", "'a' ", "\"s\\n\" ", ".5e+3 ", ">>= ", "\n#define Z 3\n", "\n"};
+
+    auto &sm          = mcc::SourceManager::instance();
+    const auto file   = sm.load("test/10k.c");
+    auto tokens       = test::lex_file(file);
+    const auto before = &sm.buffer(file);
+
+    std::mt19937 rng(42);
+    for (int i = 0; i < 100; ++i) {
+        const auto &buffer = sm.buffer(file);
+        const auto data    = buffer.data();
+
+        auto offset = static_cast<uint32_t>(rng() % buffer.size());
+        while (offset > 0 && data[offset - 1] != ' ' && data[offset - 1] != '\n') --offset;
+
+        mcc::SrcEdit edit{offset, 0, kInserts[rng() % std::size(kInserts)]};
+        if (offset > 0 && rng() % 3 == 0) edit = {offset - 1, 1, data[offset - 1] == ' ' ? "\n" : " "};
+
+        sm.update(file, edit);
+        const auto diff = mcc::relex(tokens, file, edit);
+        const auto full = test::lex_file(file);
+        if (!CHECK(test::same(tokens, full))) break;
+        CHECK(diff.first + diff.inserted <= tokens.size());
+
+        const auto text = std::string(sm.buffer(file).data(), sm.buffer(file).size());
+        for (int j = 0; j < 8; ++j) {
+            const auto at       = static_cast<uint32_t>(rng() % (text.size() + 1));
+            const auto resolved = sm.resolve({file, at});
+            CHECK(std::make_pair(resolved.linenum, resolved.column) == where(text, at));
+        }
+    }
+
+    // edited in place, not added as another file
+    CHECK(&sm.buffer(file) == before);
+
+    // an edit that does not lex leaves its error as the last token, and the
+    // edit that undoes it gets the tokens back. On the file as it is on
+    // disk, the random edits may have closed a literal or a comment.
+    const auto clean = sm.load("test/10k.c");
+    auto fresh       = test::lex_file(clean);
+    CHECK(clean != file);
+
+    struct Bad {
+        const char *text;
+        const char *message;
+    };
+    static const Bad kBad[] = {
+        {"\"abc ", "expect literal terminator."},
+        {"/* c ", "expect comment terminator `*/`."},
+        {"@ ", "unknown punctuator."},
+        {"0x ", "invalid constant."},
+        {"\"\\q\" ", "invalid escape sequence."},
+        {"\xff ", "invalid UTF-8 sequence."},
+        {"\xc3 ", "invalid UTF-8 sequence."},
+    };
+    for (const auto &bad : kBad) {
+        const auto good   = fresh;
+        const auto offset = static_cast<uint32_t>(sm.buffer(clean).size() / 2);
+        const auto length = static_cast<uint32_t>(std::string_view(bad.text).size());
+        const auto at     = static_cast<uint32_t>(std::string_view(sm.buffer(clean).data()).find('\n', offset) + 1);
+
+        sm.update(clean, {at, 0, bad.text});
+        mcc::relex(fresh, clean, {at, 0, bad.text});
+        CHECK(fresh.kind(fresh.size() - 1) == mcc::TokenKind::None);
+        CHECK(std::string_view(mcc::lex_error_message(fresh[fresh.size() - 1])) == bad.message);
+        CHECK(fresh.loc(fresh.size() - 1).offset >= at);
+
+        // an edit after the error lexes from the error on
+        const auto end = static_cast<uint32_t>(sm.buffer(clean).size());
+        sm.update(clean, {end, 0, "\n"});
+        mcc::relex(fresh, clean, {end, 0, "\n"});
+        CHECK(fresh.kind(fresh.size() - 1) == mcc::TokenKind::None);
+
+        sm.update(clean, {end, 1, ""});
+        mcc::relex(fresh, clean, {end, 1, ""});
+        sm.update(clean, {at, length, ""});
+        mcc::relex(fresh, clean, {at, length, ""});
+        CHECK(test::same(fresh, good));
+        CHECK(sm.invalid(clean) == UINT32_MAX);
+    }
+
+    // a literal ended by an escaped sentinel, as when typing `"\` at the end
+    const std::string text = "int a;\n";
+    const auto small       = sm.add("<small>", text);
+    auto typed             = test::lex_file(small);
+    const auto original    = typed;
+    sm.update(small, {7, 0, "\"\\"});
+    mcc::relex(typed, small, {7, 0, "\"\\"});
+    CHECK(typed.size() == 4 && typed.kind(3) == mcc::TokenKind::None);
+    CHECK(std::string_view(mcc::lex_error_message(typed[3])) == "expect literal terminator.");
+    CHECK(typed.loc(3).offset == 9);
+    sm.update(small, {7, 2, ""});
+    mcc::relex(typed, small, {7, 2, ""});
+    CHECK(test::same(typed, original));
+    return test::done();
+}
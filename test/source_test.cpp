@@ -0,0 +1,51 @@
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "test.hpp"
+
+/// Sources
+/// ----------------------------------------------------------------------------
+/// A view of a source in memory is copied, nothing past its end is read, so
+/// the lexer never runs on into what follows a substring. A pointer and a
+/// size followed by a '\0' are borrowed.
+auto main() -> int {
+    auto &sm               = mcc::SourceManager::instance();
+    const std::string text = "int a = 12345; int b;";
+    const auto prefix      = std::string_view(text).substr(0, 10);  // "int a = 12"
+
+    const auto whole = sm.add("<whole>", text.c_str(), text.size());
+    CHECK(sm.buffer(whole).data() == text.data());
+    CHECK(test::lex_file(whole).size() == 8);
+
+    const auto copy = sm.add("<copy>", text);
+    CHECK(sm.buffer(copy).data() != text.data());
+    CHECK(test::same(test::lex_file(copy), test::lex_file(whole)));
+
+    const auto part = sm.add("<part>", prefix);
+    CHECK(sm.buffer(part).size() == prefix.size());
+    CHECK(sm.buffer(part).data()[prefix.size()] == '\0');
+    auto tokens = test::lex_file(part);
+    CHECK(tokens.size() == 4);
+    CHECK(tokens.constants().size() == 1 && tokens.constants()[0].integer == 12);
+
+    tokens = mcc::lex(prefix, "<lex>").collect();
+    CHECK(tokens.size() == 4);
+    CHECK(tokens.constants().size() == 1 && tokens.constants()[0].integer == 12);
+
+    // exactly the bytes of the view, on the heap
+    const std::unique_ptr<char[]> bytes(new char[5]{'i', 'n', 't', ' ', 'a'});
+    tokens = mcc::lex(std::string_view(bytes.get(), 5), "<heap>").collect();
+    CHECK(tokens.size() == 2 && tokens.symbols().front().string() == "a");
+
+    // rebinding copies a view and borrows a terminated buffer again
+    sm.rebind(whole, std::string_view(text).substr(15, 5));  // "int b"
+    CHECK(sm.buffer(whole).data() != text.data());
+    CHECK(test::lex_file(whole).size() == 2);
+    sm.rebind(whole, text.c_str(), text.size());
+    CHECK(sm.buffer(whole).data() == text.data());
+    CHECK(test::lex_file(whole).size() == 8);
+
+    CHECK(test::lex_file(sm.add("<empty>", std::string_view())).size() == 0);
+    return test::done();
+}
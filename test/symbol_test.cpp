@@ -0,0 +1,30 @@
+#include <string>
+
+#include "test.hpp"
+
+/// Symbols
+/// ----------------------------------------------------------------------------
+/// Interning gives equal spellings equal symbols, including spellings longer
+/// than a block of the symbol table and the ones stored after them.
+auto main() -> int {
+    const auto a = mcc::Symbol::intern("alpha");
+    CHECK(a == mcc::Symbol::intern(std::string("alpha")));
+    CHECK(a != mcc::Symbol::intern("beta"));
+    CHECK(a.string() == "alpha");
+    CHECK(mcc::Symbol::intern("").empty());
+
+    // more than 64 KB, then more identifiers in the same shards
+    std::string source = "int " + std::string(100000, 'x') + " = 1;\n";
+    for (int i = 0; i < 2000; ++i) source += "int y" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+    source += "int " + std::string(70000, 'z') + ";\n";
+
+    auto tokens = mcc::lex(source, "<long>").collect();
+    CHECK(tokens.symbols().size() == 2002);
+    CHECK(tokens.symbols().front().string() == std::string(100000, 'x'));
+    CHECK(tokens.symbols()[1].string() == "y0");
+    CHECK(tokens.symbols()[2000].string() == "y1999");
+    CHECK(tokens.symbols().back().string() == std::string(70000, 'z'));
+    CHECK(mcc::Symbol::intern(std::string(100000, 'x')) == tokens.symbols().front());
+    CHECK(mcc::Symbol::intern("y1234").string() == "y1234");
+    return test::done();
+}
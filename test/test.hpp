@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdio>
+#include <string>
+
+#include "mcc.hpp"
+
+/// Checks
+/// ----------------------------------------------------------------------------
+/// Each test is a plain executable run from the repository root. `CHECK()`
+/// counts and prints failures, `done()` ends `main()` with the summary ctest
+/// looks for, as `panic()` exits with 0 and would otherwise pass.
+namespace test {
+
+inline size_t checks   = 0;
+inline size_t failures = 0;
+
+inline auto check(bool ok, const char *expr, const char *file, int line) -> bool {
+    ++checks;
+    if (!ok) {
+        ++failures;
+        std::printf("%s:%d: check failed: %s\n", file, line, expr);
+    }
+    return ok;
+}
+
+inline auto done() -> int {
+    if (failures) {
+        std::printf("%zu of %zu checks failed\n", failures, checks);
+        return 1;
+    }
+    std::printf("all %zu checks passed\n", checks);
+    return 0;
+}
+
+/// same tokens, spellings and values
+inline auto same(const mcc::TokenBuffer &a, const mcc::TokenBuffer &b) -> bool {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a.kind(i) != b.kind(i) || a.length(i) != b.length(i) || a.flags(i) != b.flags(i)) return false;
+        if (a[i].string() != b[i].string()) return false;
+    }
+    if (a.constants().size() != b.constants().size()) return false;
+    for (size_t i = 0; i < a.constants().size(); ++i) {
+        if (a.constants()[i].type != b.constants()[i].type || a.constants()[i].integer != b.constants()[i].integer) return false;
+    }
+    return a.symbols() == b.symbols() && a.literals() == b.literals();
+}
+
+/// all tokens of `file` from plain `lex()`, one by one below the size the
+/// parallel lexer takes over and with the token cache off
+inline auto lex_file(mcc::FileID file) -> mcc::TokenBuffer {
+    return mcc::lex(mcc::SrcStream(file)).collect();
+}
+
+}  // namespace test
+
+#define CHECK(expr) test::check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
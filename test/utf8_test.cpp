@@ -0,0 +1,129 @@
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "simd.hpp"
+#include "test.hpp"
+
+/// UTF-8
+/// ----------------------------------------------------------------------------
+/// `validate_utf8()` has to find the first ill-formed byte a byte by byte
+/// decoder finds, wherever it is in the runs of ASCII it skips in steps, and
+/// sources have to lex as `lex()` lexes them without a byte order mark.
+
+/// length of the well-formed sequence at `i`, 0 if there is none, after
+/// table 3-7 of the Unicode standard
+static auto sequence(std::string_view text, size_t i) -> size_t {
+    const auto byte = [&](size_t k) -> unsigned { return k < text.size() ? static_cast<unsigned char>(text[k]) : 0x100; };
+    const auto lead = byte(i);
+    if (lead < 0x80) return 1;
+
+    size_t length;
+    unsigned low = 0x80, high = 0xbf;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        length = 2;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        length = 3;
+        if (lead == 0xe0) low = 0xa0;
+        if (lead == 0xed) high = 0x9f;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+        if (lead == 0xf0) low = 0x90;
+        if (lead == 0xf4) high = 0x8f;
+    } else {
+        return 0;
+    }
+    if (byte(i + 1) < low || byte(i + 1) > high) return 0;
+    for (size_t k = 2; k < length; ++k) {
+        if (byte(i + k) < 0x80 || byte(i + k) > 0xbf) return 0;
+    }
+    return length;
+}
+
+static auto reference(std::string_view text, bool &ascii) -> size_t {
+    ascii = true;
+    for (size_t i = 0; i < text.size();) {
+        const auto length = sequence(text, i);
+        if (length == 0) return i;
+        if (length > 1) ascii = false;
+        i += length;
+    }
+    return text.size();
+}
+
+static auto agrees(std::string_view text) -> bool {
+    bool ascii, expected_ascii;
+    const auto bad = mcc::simd::validate_utf8(text.data(), text.size(), ascii);
+    return bad == reference(text, expected_ascii) && (bad != text.size() || ascii == expected_ascii);
+}
+
+auto main() -> int {
+    const std::string_view kSequences[] = {
+        "a", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xef\xbb\xbf", "\xf4\x8f\xbf\xbf",  // well-formed
+        "\x80", "\xbf", "\xc0\x80", "\xc1\xbf", "\xe0\x80\x80", "\xe0\x9f\xbf", "\xed\xa0\x80",       // ill-formed
+        "\xf0\x80\x80\x80", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xff", "\xc3", "\xe2\x82", "\xf0\x9f\x98",
+    };
+
+    // each sequence alone, then after runs of ASCII around the step of 64
+    for (auto text : kSequences) {
+        CHECK(agrees(text));
+        for (size_t prefix : {1, 15, 16, 31, 32, 63, 64, 65, 127, 200}) {
+            const auto padded = std::string(prefix, 'x') + std::string(text);
+            CHECK(agrees(padded));
+            CHECK(agrees(padded + std::string(prefix, 'y')));
+        }
+    }
+
+    // random mixes of ASCII runs and sequences, well-formed or not
+    std::mt19937 rng(10);
+    for (int i = 0; i < 2000; ++i) {
+        std::string text;
+        while (text.size() < 300) {
+            if (rng() % 2) {
+                text.append(rng() % 80, static_cast<char>('a' + rng() % 26));
+            } else {
+                text.append(kSequences[rng() % (i % 4 ? 6 : std::size(kSequences))]);
+            }
+        }
+        CHECK(agrees(text));
+    }
+
+    bool ascii = false;
+    CHECK(mcc::simd::validate_utf8("int a;", 6, ascii) == 6 && ascii);
+    CHECK(mcc::simd::validate_utf8("int \xc3\xa9;", 7, ascii) == 7 && !ascii);
+
+    // the byte order mark is not part of the source, and only bytes >= 0x80
+    // make it non-ASCII
+    auto &sm             = mcc::SourceManager::instance();
+    const std::string bom = "\xef\xbb\xbfint a = 'b';\n";
+    const auto with_bom  = sm.add("<bom>", bom);
+    const auto without   = sm.add("<no bom>", std::string_view(bom).substr(3));
+    CHECK(sm.buffer(with_bom).size() == bom.size() - 3);
+    CHECK(sm.ascii(with_bom));
+    CHECK(test::same(test::lex_file(with_bom), test::lex_file(without)));
+
+    const std::string utf8 = "int caf\xc3\xa9 = 1; char *s = \"\xe2\x82\xac\";\n";
+    const auto file        = sm.add("<utf-8>", utf8);
+    CHECK(!sm.ascii(file));
+    const auto tokens = test::lex_file(file);
+    CHECK(tokens.symbols().size() == 2 && tokens.symbols().front().string() == "caf\xc3\xa9");
+    CHECK(tokens.literals().size() == 1 && tokens.literals().front().string() == "\xe2\x82\xac");
+
+    // an edit that breaks a sequence is left to the lexer
+    sm.update(file, {7, 1, ""});
+    CHECK(sm.invalid(file) == 7);
+    sm.update(file, {7, 0, "\xc3"});
+    CHECK(sm.invalid(file) == UINT32_MAX);
+
+    // constants decode to their values
+    const auto constants = mcc::lex("0x1f 017 42u 10l 0xffffffffffffffffull 1.5e3 .25f", "<constants>").collect().constants();
+    CHECK(constants.size() == 7);
+    CHECK(constants[0].integer == 31 && constants[0].type == mcc::ConstantType::Int);
+    CHECK(constants[1].integer == 15);
+    CHECK(constants[2].integer == 42 && constants[2].type == mcc::ConstantType::UnsignedInt);
+    CHECK(constants[3].integer == 10 && constants[3].type == mcc::ConstantType::Long);
+    CHECK(constants[4].integer == UINT64_MAX && constants[4].type == mcc::ConstantType::UnsignedLongLong);
+    CHECK(constants[5].floating == 1500.0 && constants[5].type == mcc::ConstantType::Double);
+    CHECK(constants[6].floating == 0.25 && constants[6].type == mcc::ConstantType::Float);
+    return test::done();
+}